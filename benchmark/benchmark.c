@@ -0,0 +1,399 @@
+/*
+Copyright (c) 2023 Daniel Fedai Larsen
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "decoder.h"
+#include "decoder_binary.h"
+#include "decoder_cache.h"
+#include "decoder_classify.h"
+#include "decoder_ctx.h"
+#include "decoder_parallel.h"
+#include "decoder_stream.h"
+#include "generator.h"
+#include "timer.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_WIN32)
+#define NULL_DEVICE "NUL"
+#else
+#define NULL_DEVICE "/dev/null"
+#endif
+
+#define BENCHMARK_DEFAULT_SIZE (uint32_t)(8U << 20)
+#define BENCHMARK_DEFAULT_SEED 8086U
+/* Each benchmark runs at least this many times and until this much time has passed, the fastest run is reported */
+#define BENCHMARK_MIN_ITERATIONS 3U
+#define BENCHMARK_MIN_NANOSECONDS 500000000ULL
+
+typedef struct
+{
+    const uint8_t* stream;
+    uint32_t stream_len;
+    FILE* null_file;
+    output_buffer_t memory;     /* Emptied before every run */
+    decoder_cache_t cache;
+    decoder_binary_t binary;    /* Records are overwritten by every run */
+    uint8_t* classes;           /* Class of every byte of the stream */
+    decoder_ctx_t* memory_ctx;  /* Writes its text to 'memory' */
+    decoder_ctx_t* record_ctx;  /* Only passes on decoded instructions */
+    uint32_t record_checksum;
+} benchmark_state_t;
+
+typedef void (*benchmark_function_t)(benchmark_state_t* const state);
+
+typedef struct
+{
+    const char* name;
+    benchmark_function_t function;
+} benchmark_t;
+
+/* Keeps the results of decoding without formatting alive, so the compiler can't drop the work */
+static volatile uint32_t benchmark_sink;
+
+/**
+ * Text written through decoder_decode_stream() to a file that discards it.
+*/
+static void benchmark_text_file(benchmark_state_t* const state)
+{
+    decoder_decode_stream(state->stream, state->stream_len, state->null_file);
+}
+
+/**
+ * Text kept in memory.
+*/
+static void benchmark_text_memory(benchmark_state_t* const state)
+{
+    state->memory.size = 0;
+    decoder_decode_stream_to_buffer(state->stream, state->stream_len, &state->memory);
+}
+
+/**
+ * Text kept in memory, decoded through the cache of decoded instructions.
+*/
+static void benchmark_text_cached(benchmark_state_t* const state)
+{
+    state->memory.size = 0;
+    decoder_stream_t stream;
+    decoder_stream_init(&stream, &state->memory);
+    stream.cache = &state->cache;
+    decoder_stream_feed(&stream, state->stream, state->stream_len);
+    decoder_stream_finish(&stream);
+}
+
+/**
+ * Text kept in memory, with labels for branch targets spliced in at the end.
+*/
+static void benchmark_text_labeled(benchmark_state_t* const state)
+{
+    state->memory.size = 0;
+    decoder_decode_stream_with_labels_to_buffer(state->stream, state->stream_len, &state->memory);
+}
+
+/**
+ * Text kept in memory, through a decoder context with a memory sink.
+*/
+static void benchmark_ctx_memory(benchmark_state_t* const state)
+{
+    state->memory.size = 0;
+    decoder_ctx_decode(state->memory_ctx, state->stream, state->stream_len);
+}
+
+static void benchmark_add_record(void* const context, const uint64_t offset, const instruction_t* const inst)
+{
+    (void)offset;
+    benchmark_state_t* const state = context;
+    state->record_checksum += inst->operation + inst->immediate;
+}
+
+/**
+ * Decoded instructions without text, passed to a sink by a decoder context.
+*/
+static void benchmark_ctx_records(benchmark_state_t* const state)
+{
+    state->record_checksum = 0;
+    decoder_ctx_decode(state->record_ctx, state->stream, state->stream_len);
+    benchmark_sink = state->record_checksum;
+}
+
+/**
+ * Text kept in memory, decoded on one thread per processor.
+*/
+static void benchmark_text_parallel(benchmark_state_t* const state)
+{
+    state->memory.size = 0;
+    decoder_decode_stream_parallel(state->stream, state->stream_len, 0, &state->memory);
+}
+
+/**
+ * Binary listing kept in memory.
+*/
+static void benchmark_binary_memory(benchmark_state_t* const state)
+{
+    decoder_binary_build(&state->binary, state->stream, state->stream_len);
+}
+
+/**
+ * Decoded instructions without text.
+*/
+static void benchmark_structured(benchmark_state_t* const state)
+{
+    uint32_t index = 0;
+    uint32_t checksum = 0;
+    instruction_t inst;
+    while ((index < state->stream_len) && (decoder_decode_one(state->stream, state->stream_len, index, &inst) == true))
+    {
+        checksum += inst.operation + inst.immediate;
+        index += inst.length;
+    }
+    benchmark_sink = checksum;
+}
+
+/**
+ * Instruction lengths only.
+*/
+static void benchmark_length(benchmark_state_t* const state)
+{
+    uint32_t index = 0;
+    uint32_t inst_len;
+    while ((index < state->stream_len) && ((inst_len = decoder_decode_length(state->stream, state->stream_len, index)) > 0))
+    {
+        index += inst_len;
+    }
+    benchmark_sink = index;
+}
+
+/**
+ * Instruction lengths found with the classes of each block of the stream.
+*/
+static void benchmark_length_classified(benchmark_state_t* const state)
+{
+    decoder_classifier_t classifier;
+    decoder_classifier_init(&classifier, state->stream, state->stream_len);
+    uint32_t index = 0;
+    uint32_t inst_len;
+    while ((index < state->stream_len) && ((inst_len = decoder_classifier_get_length(&classifier, index)) > 0))
+    {
+        index += inst_len;
+    }
+    benchmark_sink = index;
+}
+
+/**
+ * Classes of every byte in the stream.
+*/
+static void benchmark_classify(benchmark_state_t* const state)
+{
+    decoder_classify(state->stream, state->stream_len, state->classes);
+}
+
+static const benchmark_t benchmarks[] = {
+    { "text_file", benchmark_text_file },
+    { "text_memory", benchmark_text_memory },
+    { "text_cached", benchmark_text_cached },
+    { "text_labeled", benchmark_text_labeled },
+    { "text_parallel", benchmark_text_parallel },
+    { "ctx_memory", benchmark_ctx_memory },
+    { "ctx_records", benchmark_ctx_records },
+    { "binary_memory", benchmark_binary_memory },
+    { "structured", benchmark_structured },
+    { "length", benchmark_length },
+    { "length_classified", benchmark_length_classified },
+    { "classify", benchmark_classify },
+};
+
+/**
+ * Run a benchmark until it has been timed enough, and return the fastest run in nanoseconds.
+*/
+static uint64_t benchmark_run(const benchmark_t* const benchmark, benchmark_state_t* const state, uint32_t* const iterations)
+{
+    uint64_t best = UINT64_MAX;
+    uint64_t total = 0;
+    uint32_t iteration = 0;
+    while ((iteration < BENCHMARK_MIN_ITERATIONS) || (total < BENCHMARK_MIN_NANOSECONDS))
+    {
+        const uint64_t start = timer_get_nanoseconds();
+        benchmark->function(state);
+        const uint64_t elapsed = timer_get_nanoseconds() - start;
+
+        best = (elapsed < best) ? elapsed : best;
+        total += elapsed;
+        iteration++;
+    }
+
+    *iterations = iteration;
+    return (best > 0) ? best : 1;
+}
+
+/**
+ * Write a generated stream to a file, to decode it with the main program.
+*/
+static int generate_file(const char* const mix_name, const uint32_t size, const char* const path)
+{
+    generator_mix_t mix;
+    if (generator_find_mix(mix_name, &mix) == false)
+    {
+        printf("[BENCHMARK] Unknown mix '%s'\n", mix_name);
+        return -1;
+    }
+
+    uint8_t* stream = malloc(size);
+    uint32_t stream_len;
+    generator_generate(mix, BENCHMARK_DEFAULT_SEED, stream, size, &stream_len);
+
+    FILE* file = fopen(path, "wb");
+    if (file == NULL)
+    {
+        printf("[FILE] Failed to open file '%s'\n", path);
+        free(stream);
+        return -1;
+    }
+    const bool success = fwrite(stream, 1, stream_len, file) == stream_len;
+    fclose(file);
+    free(stream);
+
+    return (success == true) ? 0 : -1;
+}
+
+static void print_usage(void)
+{
+    printf("Usage: benchmark [-s <bytes>] [-S <seed>] [-m <mix>] [-p <path>]\n");
+    printf("       benchmark -g <mix> <bytes> <file>\n");
+    printf("Mixes:");
+    for (uint32_t i = 0; i < GENERATOR_MIX_COUNT; i++)
+    {
+        printf(" %s", generator_get_mix_name((generator_mix_t)i));
+    }
+    printf("\nPaths:");
+    for (uint32_t i = 0; i < sizeof(benchmarks) / sizeof(benchmark_t); i++)
+    {
+        printf(" %s", benchmarks[i].name);
+    }
+    printf("\n");
+}
+
+int main(int argc, char** argv)
+{
+    /* Generate a stream instead of benchmarking */
+    if ((argc == 5) && (strcmp(argv[1], "-g") == 0))
+    {
+        return generate_file(argv[2], (uint32_t)strtoul(argv[3], NULL, 10), argv[4]);
+    }
+
+    uint32_t size = BENCHMARK_DEFAULT_SIZE;
+    uint64_t seed = BENCHMARK_DEFAULT_SEED;
+    const char* only_mix = NULL;
+    const char* only_path = NULL;
+    for (int i = 1; i < argc; i++)
+    {
+        if ((i + 1 < argc) && (strcmp(argv[i], "-s") == 0))
+        {
+            size = (uint32_t)strtoul(argv[++i], NULL, 10);
+        }
+        else if ((i + 1 < argc) && (strcmp(argv[i], "-S") == 0))
+        {
+            seed = strtoull(argv[++i], NULL, 10);
+        }
+        else if ((i + 1 < argc) && (strcmp(argv[i], "-m") == 0))
+        {
+            only_mix = argv[++i];
+        }
+        else if ((i + 1 < argc) && (strcmp(argv[i], "-p") == 0))
+        {
+            only_path = argv[++i];
+        }
+        else /* Unknown argument */
+        {
+            print_usage();
+            return -1;
+        }
+    }
+
+    decoder_init();
+    benchmark_state_t state;
+    uint8_t* stream = malloc(size);
+    state.stream = stream;
+    state.null_file = fopen(NULL_DEVICE, "wb");
+    if (state.null_file == NULL)
+    {
+        printf("[FILE] Failed to open '%s'\n", NULL_DEVICE);
+        free(stream);
+        return -1;
+    }
+    output_buffer_init(&state.memory, OUTPUT_BUFFER_DEFAULT_CAPACITY, NULL);
+    decoder_cache_init(&state.cache, 0);
+    decoder_binary_init(&state.binary);
+    state.classes = malloc(size);
+    decoder_sink_t sink;
+    decoder_sink_init_memory(&sink, &state.memory);
+    state.memory_ctx = decoder_ctx_create(NULL, &sink);
+    decoder_sink_init_records(&sink, benchmark_add_record, &state);
+    state.record_ctx = decoder_ctx_create(NULL, &sink);
+
+    /* JSON report, one result per mix and path */
+    printf("{\n  \"size\": %u,\n  \"seed\": %llu,\n  \"classify\": \"%s\",\n  \"results\": [", size, (unsigned long long)seed,
+           decoder_classify_get_implementation());
+    bool is_first = true;
+    for (uint32_t mix = 0; mix < GENERATOR_MIX_COUNT; mix++)
+    {
+        const char* const mix_name = generator_get_mix_name((generator_mix_t)mix);
+        if ((only_mix != NULL) && (strcmp(only_mix, mix_name) != 0))
+        {
+            continue;
+        }
+
+        const uint32_t inst_count = generator_generate((generator_mix_t)mix, seed, stream, size, &state.stream_len);
+        for (uint32_t i = 0; i < sizeof(benchmarks) / sizeof(benchmark_t); i++)
+        {
+            const benchmark_t* const benchmark = &benchmarks[i];
+            if ((only_path != NULL) && (strcmp(only_path, benchmark->name) != 0))
+            {
+                continue;
+            }
+
+            uint32_t iterations;
+            const uint64_t nanoseconds = benchmark_run(benchmark, &state, &iterations);
+            const double seconds = (double)nanoseconds / 1e9;
+            printf("%s\n    {\"mix\": \"%s\", \"path\": \"%s\", \"bytes\": %u, \"instructions\": %u, \"iterations\": %u, "
+                   "\"best_seconds\": %.6f, \"mb_per_s\": %.2f, \"instructions_per_s\": %.0f, \"ns_per_instruction\": %.3f}",
+                   (is_first == true) ? "" : ",", mix_name, benchmark->name, state.stream_len, inst_count, iterations,
+                   seconds, ((double)state.stream_len / 1e6) / seconds, (double)inst_count / seconds,
+                   (inst_count > 0) ? (double)nanoseconds / inst_count : 0.0);
+            is_first = false;
+        }
+    }
+    printf("\n  ]\n}\n");
+
+    decoder_ctx_destroy(state.record_ctx);
+    decoder_ctx_destroy(state.memory_ctx);
+    free(state.classes);
+    decoder_binary_free(&state.binary);
+    decoder_cache_free(&state.cache);
+    output_buffer_free(&state.memory);
+    fclose(state.null_file);
+    free(stream);
+    return 0;
+}
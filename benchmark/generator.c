@@ -0,0 +1,329 @@
+/*
+Copyright (c) 2023 Daniel Fedai Larsen
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "generator.h"
+
+#include "decoder.h"
+#include "instruction.h"
+
+#include <string.h>
+
+#define GENERATOR_PREFIX_LOCK  0xF0
+#define GENERATOR_PREFIX_REPNE 0xF2
+#define GENERATOR_PREFIX_REP   0xF3
+/* ES: segment override, the segment register is in bits 3-4 */
+#define GENERATOR_PREFIX_SEGMENT 0x26
+
+#define GENERATOR_MOD_MEMORY         0U
+#define GENERATOR_MOD_DISPLACEMENT8  1U
+#define GENERATOR_MOD_DISPLACEMENT16 2U
+#define GENERATOR_MOD_REGISTER       3U
+
+typedef struct
+{
+    uint8_t first;
+    uint8_t last;
+    uint8_t weight;
+} generator_opcode_range_t;
+
+/* Rough opcode frequencies of compiled 16-bit code, opcodes in a range are equally likely */
+static const generator_opcode_range_t generator_weighted_opcodes[] = {
+    { 0x88, 0x8B, 25 }, /* mov r/m */
+    { 0x50, 0x5F, 12 }, /* push/pop reg */
+    { 0x70, 0x7F,  8 }, /* jcc */
+    { 0xB8, 0xBF,  6 }, /* mov reg16, imm */
+    { 0x83, 0x83,  6 }, /* arithmetic with imm8 */
+    { 0xE8, 0xE8,  5 }, /* call */
+    { 0x38, 0x3B,  5 }, /* cmp */
+    { 0x40, 0x4F,  5 }, /* inc/dec reg */
+    { 0x00, 0x03,  4 }, /* add */
+    { 0x28, 0x2B,  3 }, /* sub */
+    { 0x30, 0x33,  3 }, /* xor */
+    { 0x84, 0x85,  3 }, /* test */
+    { 0x8D, 0x8D,  3 }, /* lea */
+    { 0xC3, 0xC3,  3 }, /* ret */
+    { 0xEB, 0xEB,  3 }, /* jmp short */
+    { 0xFF, 0xFF,  3 }, /* inc/dec/call/jmp/push r/m */
+    { 0x20, 0x23,  2 }, /* and */
+    { 0xB0, 0xB7,  2 }, /* mov reg8, imm */
+    { 0xE9, 0xE9,  1 }, /* jmp near */
+};
+
+/* MOD field frequencies for the weighted mix, indexed by MOD */
+static const uint8_t generator_weighted_mods[4] = { 15, 35, 5, 45 };
+
+static const char* generator_mix_names[GENERATOR_MIX_COUNT] = {
+    "uniform",
+    "weighted",
+    "register",
+    "disp16",
+    "short",
+    "pathological",
+};
+
+/**
+ * Opcodes sorted into the lists the mixes draw from, found by decoding probes.
+*/
+typedef struct
+{
+    bool is_initialized;
+    uint8_t valid[256];
+    uint32_t valid_count;
+    uint8_t modrm[256];        /* Opcodes followed by a ModR/M byte */
+    uint32_t modrm_count;
+    uint8_t one_byte[256];     /* Complete instructions of a single byte */
+    uint32_t one_byte_count;
+    bool has_modrm[256];
+} generator_opcodes_t;
+
+static generator_opcodes_t generator_opcodes;
+
+static bool generator_is_prefix(const uint8_t opcode)
+{
+    return (opcode == GENERATOR_PREFIX_LOCK) || (opcode == GENERATOR_PREFIX_REPNE) || (opcode == GENERATOR_PREFIX_REP) ||
+           ((opcode & 0xE7) == GENERATOR_PREFIX_SEGMENT);
+}
+
+/**
+ * xorshift64*, the same sequence on every platform unlike rand().
+*/
+static uint32_t generator_random(uint64_t* const state)
+{
+    *state ^= *state >> 12;
+    *state ^= *state << 25;
+    *state ^= *state >> 27;
+    return (uint32_t)((*state * 0x2545F4914F6CDD1DULL) >> 32);
+}
+
+/**
+ * Decode an opcode with every REG field and with a register and a direct address operand. An opcode is valid when any
+ * probe decodes, and has a ModR/M byte when the direct address makes it longer.
+*/
+static void generator_init(void)
+{
+    if (generator_opcodes.is_initialized == true)
+    {
+        return;
+    }
+
+    for (uint32_t opcode = 0; opcode < 256; opcode++)
+    {
+        if (generator_is_prefix((uint8_t)opcode) == true)
+        {
+            continue;
+        }
+
+        bool is_valid = false;
+        bool has_modrm = false;
+        bool is_one_byte = false;
+        for (uint8_t reg = 0; reg < 8; reg++)
+        {
+            uint8_t probe[INSTRUCTION_MAX_LENGTH] = { 0 };
+            instruction_t register_inst;
+            instruction_t memory_inst;
+            probe[0] = (uint8_t)opcode;
+            probe[1] = (uint8_t)((GENERATOR_MOD_REGISTER << 6) | (reg << 3));
+            const bool register_valid = decoder_decode_one(probe, sizeof(probe), 0, &register_inst);
+            probe[1] = (uint8_t)((GENERATOR_MOD_MEMORY << 6) | (reg << 3) | 0x6);
+            const bool memory_valid = decoder_decode_one(probe, sizeof(probe), 0, &memory_inst);
+
+            is_valid = (is_valid == true) || (register_valid == true) || (memory_valid == true);
+            if ((register_valid == true) && (memory_valid == true) && (memory_inst.length != register_inst.length))
+            {
+                has_modrm = true;
+            }
+            if ((register_valid == true) && (register_inst.length == 1))
+            {
+                is_one_byte = true;
+            }
+        }
+
+        if (is_valid == true)
+        {
+            generator_opcodes.valid[generator_opcodes.valid_count++] = (uint8_t)opcode;
+        }
+        if (has_modrm == true)
+        {
+            generator_opcodes.modrm[generator_opcodes.modrm_count++] = (uint8_t)opcode;
+        }
+        if (is_one_byte == true)
+        {
+            generator_opcodes.one_byte[generator_opcodes.one_byte_count++] = (uint8_t)opcode;
+        }
+        generator_opcodes.has_modrm[opcode] = has_modrm;
+    }
+
+    generator_opcodes.is_initialized = true;
+}
+
+static uint8_t generator_pick_weighted_opcode(uint64_t* const state)
+{
+    uint32_t total_weight = 0;
+    for (uint32_t i = 0; i < sizeof(generator_weighted_opcodes) / sizeof(generator_opcode_range_t); i++)
+    {
+        total_weight += generator_weighted_opcodes[i].weight;
+    }
+
+    uint32_t pick = generator_random(state) % total_weight;
+    const generator_opcode_range_t* range = &generator_weighted_opcodes[0];
+    for (uint32_t i = 0; pick >= range->weight; i++)
+    {
+        pick -= range->weight;
+        range = &generator_weighted_opcodes[i + 1];
+    }
+
+    return (uint8_t)(range->first + (generator_random(state) % (range->last - range->first + 1U)));
+}
+
+static uint8_t generator_pick_weighted_mod(uint64_t* const state)
+{
+    uint32_t pick = generator_random(state) % 100U;
+    uint8_t mod = 0;
+    while (pick >= generator_weighted_mods[mod])
+    {
+        pick -= generator_weighted_mods[mod];
+        mod++;
+    }
+
+    return mod;
+}
+
+/**
+ * Build random instructions of a mix until one decodes, and copy it to 'output'. Returns its length.
+*/
+static uint32_t generator_generate_one(const generator_mix_t mix, uint64_t* const state, uint8_t* const output)
+{
+    instruction_t inst;
+    uint8_t candidate[INSTRUCTION_MAX_LENGTH];
+    while (true)
+    {
+        for (uint32_t i = 0; i < sizeof(candidate); i++)
+        {
+            candidate[i] = (uint8_t)generator_random(state);
+        }
+
+        /* Prefixes */
+        uint32_t opcode_index = 0;
+        if (mix == GENERATOR_MIX_PATHOLOGICAL)
+        {
+            candidate[opcode_index++] = GENERATOR_PREFIX_LOCK;
+            candidate[opcode_index++] = ((generator_random(state) & 1) == 0) ? GENERATOR_PREFIX_REP : GENERATOR_PREFIX_REPNE;
+            candidate[opcode_index++] = (uint8_t)(GENERATOR_PREFIX_SEGMENT | ((generator_random(state) & 0x3) << 3));
+        }
+        else if ((mix == GENERATOR_MIX_UNIFORM) && ((generator_random(state) & 0xF) == 0))
+        {
+            candidate[opcode_index++] = (uint8_t)(GENERATOR_PREFIX_SEGMENT | ((generator_random(state) & 0x3) << 3));
+        }
+
+        /* Opcode */
+        uint8_t opcode;
+        switch (mix)
+        {
+        case GENERATOR_MIX_WEIGHTED:
+            opcode = generator_pick_weighted_opcode(state);
+            break;
+        case GENERATOR_MIX_REGISTER:
+        case GENERATOR_MIX_DISP16:
+        case GENERATOR_MIX_PATHOLOGICAL:
+            opcode = generator_opcodes.modrm[generator_random(state) % generator_opcodes.modrm_count];
+            break;
+        case GENERATOR_MIX_SHORT:
+            opcode = generator_opcodes.one_byte[generator_random(state) % generator_opcodes.one_byte_count];
+            break;
+        default: /* GENERATOR_MIX_UNIFORM */
+            opcode = generator_opcodes.valid[generator_random(state) % generator_opcodes.valid_count];
+            break;
+        }
+        candidate[opcode_index] = opcode;
+
+        /* Addressing mode */
+        if (generator_opcodes.has_modrm[opcode] == true)
+        {
+            uint8_t* const modrm = &candidate[opcode_index + 1];
+            switch (mix)
+            {
+            case GENERATOR_MIX_WEIGHTED:
+                *modrm = (uint8_t)((generator_pick_weighted_mod(state) << 6) | (*modrm & 0x3F));
+                break;
+            case GENERATOR_MIX_REGISTER:
+                *modrm = (uint8_t)((GENERATOR_MOD_REGISTER << 6) | (*modrm & 0x3F));
+                break;
+            case GENERATOR_MIX_DISP16:
+            case GENERATOR_MIX_PATHOLOGICAL:
+                *modrm = (uint8_t)((GENERATOR_MOD_DISPLACEMENT16 << 6) | (*modrm & 0x3F));
+                break;
+            default: /* Any MOD */
+                break;
+            }
+        }
+
+        if ((decoder_decode_one(candidate, sizeof(candidate), 0, &inst) == true) &&
+            ((mix != GENERATOR_MIX_SHORT) || (inst.length == 1)))
+        {
+            memcpy(output, candidate, inst.length);
+            return inst.length;
+        }
+    }
+}
+
+const char* generator_get_mix_name(const generator_mix_t mix)
+{
+    return generator_mix_names[mix];
+}
+
+bool generator_find_mix(const char* const name, generator_mix_t* const mix)
+{
+    for (uint32_t i = 0; i < GENERATOR_MIX_COUNT; i++)
+    {
+        if (strcmp(name, generator_mix_names[i]) == 0)
+        {
+            *mix = (generator_mix_t)i;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+uint32_t generator_generate(const generator_mix_t mix, const uint64_t seed, uint8_t* const output, const uint32_t output_len, uint32_t* const stream_len)
+{
+    generator_init();
+
+    /* xorshift must not start at zero */
+    uint64_t state = seed ^ 0x9E3779B97F4A7C15ULL;
+    if (state == 0)
+    {
+        state = 1;
+    }
+
+    uint32_t index = 0;
+    uint32_t inst_count = 0;
+    while ((output_len - index) >= INSTRUCTION_MAX_LENGTH)
+    {
+        index += generator_generate_one(mix, &state, output + index);
+        inst_count++;
+    }
+
+    *stream_len = index;
+    return inst_count;
+}
@@ -0,0 +1,70 @@
+/*
+Copyright (c) 2023 Daniel Fedai Larsen
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef GENERATOR_H
+#define GENERATOR_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef enum
+{
+    GENERATOR_MIX_UNIFORM = 0,  /* Every valid opcode equally likely, random operands */
+    GENERATOR_MIX_WEIGHTED,     /* Opcode and addressing mode frequencies of typical compiled code */
+    GENERATOR_MIX_REGISTER,     /* ModR/M instructions with register operands only (MOD=11) */
+    GENERATOR_MIX_DISP16,       /* ModR/M instructions with a 16-bit displacement (MOD=10) */
+    GENERATOR_MIX_SHORT,        /* One-byte instructions only */
+    GENERATOR_MIX_PATHOLOGICAL, /* LOCK, REP and segment prefixes on ModR/M instructions with a 16-bit displacement */
+    GENERATOR_MIX_COUNT
+} generator_mix_t;
+
+/**
+ * @brief Get the name of a mix, as used on the command line and in reports
+*/
+const char* generator_get_mix_name(const generator_mix_t mix);
+
+/**
+ * @brief Look up a mix by name
+ *
+ * @param name Name of the mix
+ * @param mix Receives the mix
+ * @return false if no mix has that name
+*/
+bool generator_find_mix(const char* const name, generator_mix_t* const mix);
+
+/**
+ * @brief Fill a buffer with a stream of valid instructions
+ *
+ * The stream only depends on the mix and the seed. Every instruction is checked with the decoder before it's added,
+ * so the whole stream decodes without errors.
+ *
+ * @param mix Kind of instructions to generate
+ * @param seed Seed of the random number generator
+ * @param output Buffer to fill
+ * @param output_len Size of 'output' in bytes
+ * @param stream_len Receives the length of the stream, at most INSTRUCTION_MAX_LENGTH - 1 bytes short of 'output_len'
+ * @return Number of instructions in the stream
+*/
+uint32_t generator_generate(const generator_mix_t mix, const uint64_t seed, uint8_t* const output, const uint32_t output_len, uint32_t* const stream_len);
+
+#endif
@@ -23,62 +23,464 @@ WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 #include "decoder.h"
 
-#include "decoder_add.h"
-#include "decoder_mov.h"
+#include "decoder_format.h"
+#include "decoder_stream.h"
+#include "decoder_table.h"
 
 #include <stdio.h>
-#include <stdlib.h>
-
-#define REGISTER_COUNT (uint8_t)8U
-#define ADDRESS_CALC_COUNT (uint8_t)8U
-
-typedef enum
-{
-    OPCODE_ADD                   = 0b00000000,
-    OPCODE_ADD_IMM_TO_REG_OR_MEM = 0b10000000,
-    OPCODE_ADD_IMM_TO_ACC        = 0b00000100,
-    OPCODE_MOV                   = 0b10001000,
-    OPCODE_MOV_IMM_TO_REG_OR_MEM = 0b11000110,
-    OPCODE_MOV_IMM_TO_REG        = 0b10110000,
-    OPCODE_MOV_MEM_TO_ACC        = 0b10100000,
-    OPCODE_MOV_ACC_TO_MEM        = 0b10100010,
-} opcode_t;
-
-static const char* reg_to_reg_name[2][REGISTER_COUNT] = {
-    /* W=0 */
-    {
-        "al",
-        "cl",
-        "dl",
-        "bl",
-        "ah",
-        "ch",
-        "dh",
-        "bh",
-    },
-    /* W=1 */
-    {
-        "ax",
-        "cx",
-        "dx",
-        "bx",
-        "sp",
-        "bp",
-        "si",
-        "di"
-    }
-};
-
-static const char* r_m_to_addr_calc_name[ADDRESS_CALC_COUNT] = {
-    "bx + si",
-    "bx + di",
-    "bp + si",
-    "bp + di",
-    "si",
-    "di",
-    "bp",
-    "bx"
-};
+#include <string.h>
+
+#define OPCODE_COUNT 256U
+#define MODRM_COUNT 256U
+/* First bytes shared by instructions that REG tells apart */
+#define OPCODE_GROUP_COUNT 16U
+#define OPCODE_GROUP_SIZE 8U
+/* Bytes loaded at once from the opcode on, enough for the opcode, ModR/M, displacement and immediate */
+#define DECODER_FETCH_SIZE 8U
+/* Bytes read from the start of an instruction, a shorter tail of the stream is decoded from a zero-padded copy */
+#define DECODER_PADDED_SIZE (INSTRUCTION_MAX_PREFIX_COUNT + DECODER_FETCH_SIZE)
+
+/**
+ * Everything needed to decode an instruction from its first byte, taken from the matching entry in 'instruction_specs'.
+ * Bytes shared by several instructions point to a group with one entry per value of REG.
+*/
+typedef struct
+{
+    uint8_t spec;      /* Index into 'instruction_specs' plus one, 0 if the byte is unknown */
+    uint8_t group;     /* Index into 'opcode_groups' plus one if REG selects the instruction, 0 otherwise */
+    uint8_t has_modrm; /* A ModR/M byte follows the opcode */
+    uint8_t d;         /* D bit, 1 if the opcode has none */
+    uint8_t w;         /* W bit, the width of the spec if the opcode has none */
+    uint8_t s;         /* S bit */
+    uint8_t vz;        /* V or Z bit */
+    uint8_t reg;       /* Register or segment register encoded in the opcode */
+    uint8_t is_prefix; /* The byte is a prefix to the next instruction */
+    uint8_t length;    /* Length in bytes without prefixes and displacement */
+} opcode_info_t;
+
+/**
+ * Bytes of an instruction from the opcode on, loaded with a single read. Fields are taken from the low end of 'bytes'
+ * as they're decoded, so decoding them doesn't touch memory or check bounds.
+*/
+typedef struct
+{
+    uint64_t bytes;     /* Bytes not decoded yet, the next one in the lowest 8 bits */
+    uint32_t length;    /* Bytes decoded so far */
+} decoder_fetch_t;
+
+/* Decoding information for every possible first byte, built once from 'instruction_specs' */
+static opcode_info_t opcode_infos[OPCODE_COUNT];
+static opcode_info_t opcode_groups[OPCODE_GROUP_COUNT][OPCODE_GROUP_SIZE];
+
+/* Decoded fields of every possible ModR/M byte */
+static modrm_t modrm_table[MODRM_COUNT];
+
+static bool decoder_initialized = false;
+
+static void decoder_init_modrm_table(void)
+{
+    for (uint32_t i = 0; i < MODRM_COUNT; i++)
+    {
+        modrm_t* const modrm = &modrm_table[i];
+        modrm->mod = (i & 0b11000000) >> 6;
+        modrm->reg = (i & 0b00111000) >> 3;
+        modrm->rm = i & 0b00000111;
+        modrm->is_register = modrm->mod == 0b11;
+        modrm->is_direct_address = (modrm->mod == 0b00) && (modrm->rm == 0b110);
+        modrm->effective_address = (modrm->is_direct_address == true) ? EFFECTIVE_ADDRESS_DIRECT : modrm->rm;
+        modrm->effective_address_name = decoder_format_get_effective_address_name(modrm->effective_address);
+
+        /* See the MOD field in the comment on 'decoder_decode_stream' */
+        modrm->displacement_size = 0;
+        modrm->flags = 0;
+        if (modrm->is_direct_address == true)
+        {
+            modrm->displacement_size = 2;
+        }
+        else if ((modrm->mod == 0b01) || (modrm->mod == 0b10))
+        {
+            modrm->displacement_size = modrm->mod;
+            modrm->flags = INSTRUCTION_FLAG_HAS_DISPLACEMENT;
+        }
+    }
+}
+
+/**
+ * Match a first byte against the pattern of a spec and extract its fields.
+*/
+static bool decoder_match_spec(const instruction_spec_t* const spec, const uint8_t opcode, opcode_info_t* const info)
+{
+    bool has_w = false;
+    memset(info, 0, sizeof(opcode_info_t));
+    info->d = 1;
+    for (uint32_t i = 0; i < 8; i++)
+    {
+        const uint8_t bit = (opcode >> (7 - i)) & 0b1;
+        switch (spec->pattern[i])
+        {
+            case '0':
+            case '1':
+            {
+                if (bit != (uint8_t)(spec->pattern[i] - '0'))
+                {
+                    return false;
+                }
+                break;
+            }
+            case 'd':
+            {
+                info->d = bit;
+                break;
+            }
+            case 'w':
+            {
+                info->w = bit;
+                has_w = true;
+                break;
+            }
+            case 's':
+            {
+                info->s = bit;
+                break;
+            }
+            case 'v':
+            case 'z':
+            {
+                info->vz = bit;
+                break;
+            }
+            default: /* 'r' or 'g' */
+            {
+                info->reg = (info->reg << 1) | bit;
+                break;
+            }
+        }
+    }
+
+    if (has_w == false)
+    {
+        info->w = spec->w;
+    }
+    info->is_prefix = (spec->flags & SPEC_FLAG_PREFIX) != 0;
+    info->has_modrm = (spec->reg != SPEC_NO_REG);
+    uint8_t immediate_length = 0;
+    for (uint32_t i = 0; i < INSTRUCTION_OPERAND_COUNT; i++)
+    {
+        switch (spec->operands[i])
+        {
+            case OPERAND_TEMPLATE_RM:
+            case OPERAND_TEMPLATE_REG:
+            case OPERAND_TEMPLATE_SREG:
+            case OPERAND_TEMPLATE_ESC:
+            {
+                info->has_modrm = true;
+                break;
+            }
+            case OPERAND_TEMPLATE_IMM:
+            {
+                immediate_length += ((info->s == 0) && (info->w == 1)) ? 2 : 1;
+                break;
+            }
+            case OPERAND_TEMPLATE_IMM8:
+            case OPERAND_TEMPLATE_BASE:
+            case OPERAND_TEMPLATE_REL8:
+            {
+                immediate_length += 1;
+                break;
+            }
+            case OPERAND_TEMPLATE_IMM16:
+            case OPERAND_TEMPLATE_ADDR:
+            case OPERAND_TEMPLATE_REL16:
+            {
+                immediate_length += 2;
+                break;
+            }
+            case OPERAND_TEMPLATE_FAR_POINTER:
+            {
+                immediate_length += 4;
+                break;
+            }
+            default:
+            {
+                break;
+            }
+        }
+    }
+    info->length = 1 + info->has_modrm + immediate_length;
+
+    return true;
+}
+
+void decoder_init(void)
+{
+    if (decoder_initialized == true)
+    {
+        return;
+    }
+
+    decoder_init_modrm_table();
+
+    uint32_t group_count = 0;
+    memset(opcode_infos, 0, sizeof(opcode_infos));
+    memset(opcode_groups, 0, sizeof(opcode_groups));
+    for (uint32_t opcode = 0; opcode < OPCODE_COUNT; opcode++)
+    {
+        opcode_info_t* const info = &opcode_infos[opcode];
+        for (uint32_t i = 0; i < instruction_spec_count; i++)
+        {
+            const instruction_spec_t* const spec = &instruction_specs[i];
+            opcode_info_t match;
+            if (decoder_match_spec(spec, (uint8_t)opcode, &match) == false)
+            {
+                continue;
+            }
+            match.spec = (uint8_t)(i + 1);
+
+            if (spec->reg == SPEC_NO_REG)
+            {
+                *info = match;
+                break;
+            }
+
+            /* REG selects the instruction, the byte itself keeps the first match so truncation can be reported */
+            if (info->group == 0)
+            {
+                *info = match;
+                info->group = (uint8_t)(++group_count);
+            }
+            opcode_groups[info->group - 1][spec->reg] = match;
+        }
+    }
+
+    decoder_initialized = true;
+}
+
+/**
+ * Load the bytes of an instruction in one go, the first one in the lowest bits. The decoder only runs on little-endian
+ * hosts, like the 8086 itself.
+*/
+static void decoder_fetch(decoder_fetch_t* const fetch, const uint8_t* const bytes)
+{
+    memcpy(&fetch->bytes, bytes, sizeof(fetch->bytes));
+    fetch->length = 0;
+}
+
+static uint8_t decoder_fetch_byte(decoder_fetch_t* const fetch)
+{
+    const uint8_t value = (uint8_t)fetch->bytes;
+    fetch->bytes >>= 8;
+    fetch->length++;
+    return value;
+}
+
+static uint16_t decoder_fetch_word(decoder_fetch_t* const fetch)
+{
+    const uint16_t value = (uint16_t)fetch->bytes;
+    fetch->bytes >>= 16;
+    fetch->length += 2;
+    return value;
+}
+
+static uint16_t decoder_get_displacement(decoder_fetch_t* const fetch, const bool is_16_bit)
+{
+    if (is_16_bit == true)
+    {
+        return decoder_fetch_word(fetch);
+    }
+
+    /* Sign-extend */
+    return (uint16_t)(int16_t)(int8_t)decoder_fetch_byte(fetch);
+}
+
+static uint16_t decoder_get_immediate(decoder_fetch_t* const fetch, const uint8_t s, const uint8_t w)
+{
+    /* 16-bit value */
+    if ((s == 0) && (w == 1))
+    {
+        return decoder_fetch_word(fetch);
+    }
+
+    /* Sign-extend */
+    const uint8_t immediate = decoder_fetch_byte(fetch);
+    if ((s == 1) && (w == 1))
+    {
+        return (uint16_t)(int16_t)(int8_t)immediate;
+    }
+
+    return immediate;
+}
+
+static void decoder_get_reg_operand(const uint8_t w, const uint8_t reg, operand_t* const operand)
+{
+    operand->kind = OPERAND_REGISTER;
+    operand->value = (w << 3) | reg;
+}
+
+static void decoder_get_regmem_operand(decoder_fetch_t* const fetch, const modrm_t* const modrm, const uint8_t w, instruction_t* const inst, operand_t* const operand)
+{
+    /* Register mode, R/M is treated as the REG field */
+    if (modrm->is_register == true)
+    {
+        decoder_get_reg_operand(w, modrm->rm, operand);
+        return;
+    }
+
+    operand->kind = OPERAND_MEMORY;
+    operand->value = modrm->effective_address;
+    inst->flags |= modrm->flags;
+
+    /* 8-bit displacements are sign-extended, a 16-bit one is either a displacement or a direct address */
+    if (modrm->displacement_size != 0)
+    {
+        inst->displacement = decoder_get_displacement(fetch, modrm->displacement_size == 2);
+    }
+}
+
+static void decoder_apply_prefix(const instruction_spec_t* const spec, const opcode_info_t* const info, instruction_t* const inst)
+{
+    switch (spec->operation)
+    {
+        case OPERATION_LOCK:
+        {
+            inst->flags |= INSTRUCTION_FLAG_LOCK;
+            break;
+        }
+        case OPERATION_REP:
+        {
+            inst->flags |= (info->vz == 1) ? INSTRUCTION_FLAG_REP : INSTRUCTION_FLAG_REPNE;
+            break;
+        }
+        default: /* OPERATION_SEGMENT */
+        {
+            inst->flags |= INSTRUCTION_FLAG_SEGMENT_OVERRIDE;
+            inst->segment = REGISTER_ES + info->reg;
+            break;
+        }
+    }
+}
+
+/**
+ * Decode one operand from its template, taking any bytes it needs from the fetched instruction. Returns true if the
+ * operand is a register that gives the size of the operation.
+*/
+static bool decoder_decode_operand(decoder_fetch_t* const fetch, const uint8_t operand_template, const opcode_info_t* const info, const modrm_t* const modrm, instruction_t* const inst, operand_t* const operand)
+{
+    switch (operand_template)
+    {
+        case OPERAND_TEMPLATE_NONE:
+        {
+            return false;
+        }
+        case OPERAND_TEMPLATE_RM:
+        {
+            decoder_get_regmem_operand(fetch, modrm, info->w, inst, operand);
+            return operand->kind == OPERAND_REGISTER;
+        }
+        case OPERAND_TEMPLATE_REG:
+        {
+            decoder_get_reg_operand(info->w, modrm->reg, operand);
+            return true;
+        }
+        case OPERAND_TEMPLATE_SREG:
+        {
+            operand->kind = OPERAND_REGISTER;
+            operand->value = REGISTER_ES + (modrm->reg & 0b11);
+            return true;
+        }
+        case OPERAND_TEMPLATE_OPCODE_REG:
+        {
+            decoder_get_reg_operand(info->w, info->reg, operand);
+            return true;
+        }
+        case OPERAND_TEMPLATE_OPCODE_SREG:
+        {
+            operand->kind = OPERAND_REGISTER;
+            operand->value = REGISTER_ES + info->reg;
+            return true;
+        }
+        case OPERAND_TEMPLATE_ACC:
+        {
+            decoder_get_reg_operand(info->w, 0b000, operand);
+            return true;
+        }
+        case OPERAND_TEMPLATE_DX:
+        {
+            operand->kind = OPERAND_REGISTER;
+            operand->value = REGISTER_DX;
+            return false;
+        }
+        case OPERAND_TEMPLATE_SHIFT_COUNT:
+        {
+            if (info->vz == 1)
+            {
+                operand->kind = OPERAND_REGISTER;
+                operand->value = REGISTER_CL;
+            }
+            else /* Shift by one */
+            {
+                operand->kind = OPERAND_IMMEDIATE;
+                inst->immediate = 1;
+            }
+            return false;
+        }
+        case OPERAND_TEMPLATE_IMM:
+        {
+            operand->kind = OPERAND_IMMEDIATE;
+            inst->immediate = decoder_get_immediate(fetch, info->s, info->w);
+            if ((info->s == 1) && (info->w == 1))
+            {
+                inst->flags |= INSTRUCTION_FLAG_SIGN_EXTENDED;
+            }
+            return false;
+        }
+        case OPERAND_TEMPLATE_IMM8:
+        {
+            operand->kind = OPERAND_IMMEDIATE;
+            inst->immediate = decoder_get_immediate(fetch, 0, 0);
+            return false;
+        }
+        case OPERAND_TEMPLATE_IMM16:
+        {
+            operand->kind = OPERAND_IMMEDIATE;
+            inst->immediate = decoder_get_immediate(fetch, 0, 1);
+            return false;
+        }
+        case OPERAND_TEMPLATE_BASE:
+        {
+            /* Base 10 is implied by the plain mnemonic */
+            inst->immediate = decoder_get_immediate(fetch, 0, 0);
+            operand->kind = (inst->immediate == 10) ? OPERAND_NONE : OPERAND_IMMEDIATE;
+            return false;
+        }
+        case OPERAND_TEMPLATE_ESC:
+        {
+            operand->kind = OPERAND_IMMEDIATE;
+            inst->immediate = (uint16_t)((info->reg << 3) | modrm->reg);
+            return false;
+        }
+        case OPERAND_TEMPLATE_ADDR:
+        {
+            operand->kind = OPERAND_MEMORY;
+            operand->value = EFFECTIVE_ADDRESS_DIRECT;
+            inst->displacement = decoder_get_displacement(fetch, true);
+            return false;
+        }
+        case OPERAND_TEMPLATE_REL8:
+        case OPERAND_TEMPLATE_REL16:
+        {
+            operand->kind = OPERAND_RELATIVE;
+            inst->immediate = decoder_get_displacement(fetch, operand_template == OPERAND_TEMPLATE_REL16);
+            return false;
+        }
+        default: /* OPERAND_TEMPLATE_FAR_POINTER */
+        {
+            operand->kind = OPERAND_FAR_POINTER;
+            inst->displacement = decoder_get_displacement(fetch, true);
+            inst->immediate = decoder_get_displacement(fetch, true);
+            return false;
+        }
+    }
+}
 
 /**
  * See page 4-18 in the manual.
@@ -126,100 +528,268 @@ static const char* r_m_to_addr_calc_name[ADDRESS_CALC_COUNT] = {
 */
 void decoder_decode_stream(const uint8_t* const inst_stream, const uint32_t inst_stream_len, FILE* output_file)
 {
-    fprintf(output_file, "bits 16\n\n");
+    output_buffer_t buffer;
+    output_buffer_init(&buffer, OUTPUT_BUFFER_DEFAULT_CAPACITY, output_file);
+    decoder_decode_stream_to_buffer(inst_stream, inst_stream_len, &buffer);
+    output_buffer_free(&buffer);
+}
+
+void decoder_decode_stream_to_buffer(const uint8_t* const inst_stream, const uint32_t inst_stream_len, output_buffer_t* const buffer)
+{
+    decoder_stream_t stream;
+    decoder_stream_init(&stream, buffer);
+    decoder_stream_feed(&stream, inst_stream, inst_stream_len);
+    decoder_stream_finish(&stream);
+}
 
-    uint32_t index = 0;
-    while (index < inst_stream_len)
+void decoder_decode_stream_with_labels(const uint8_t* const inst_stream, const uint32_t inst_stream_len, FILE* output_file)
+{
+    output_buffer_t buffer;
+    output_buffer_init(&buffer, OUTPUT_BUFFER_DEFAULT_CAPACITY, output_file);
+    decoder_decode_stream_with_labels_to_buffer(inst_stream, inst_stream_len, &buffer);
+    output_buffer_free(&buffer);
+}
+
+void decoder_decode_stream_with_labels_to_buffer(const uint8_t* const inst_stream, const uint32_t inst_stream_len, output_buffer_t* const buffer)
+{
+    decoder_labels_t labels;
+    decoder_stream_t stream;
+    decoder_stream_init(&stream, buffer);
+    decoder_labels_init(&labels, buffer);
+    stream.labels = &labels;
+    decoder_stream_feed(&stream, inst_stream, inst_stream_len);
+    decoder_stream_finish(&stream);
+    decoder_labels_free(&labels);
+}
+
+/**
+ * Get where to read an instruction from. Near the end of the stream the remaining bytes are copied into 'padded', so
+ * the instruction can be read in full without checking the length of the stream for every byte.
+*/
+static const uint8_t* decoder_get_padded(const uint8_t* const inst_stream, const uint32_t inst_stream_len, const uint32_t inst_stream_index, uint8_t* const padded)
+{
+    const uint32_t available = inst_stream_len - inst_stream_index;
+    if (available >= DECODER_PADDED_SIZE)
     {
-        /* Determine OPCODE */
-        const opcode_t opcode = inst_stream[index];
-        if ((opcode & 0b11111100) == OPCODE_ADD)
-        {
-            decode_add_regmem_reg(inst_stream, &index, output_file);
-        }
-        else if ((opcode & 0b11111100) == OPCODE_ADD_IMM_TO_REG_OR_MEM)
-        {
-            decode_add_imm_to_regmem(inst_stream, &index, output_file);
-        }
-        else if ((opcode & 0b11111110) == OPCODE_ADD_IMM_TO_ACC)
-        {
-            decode_add_imm_to_acc(inst_stream, &index, output_file);
-        }
-        else if ((opcode & 0b11111100) == OPCODE_MOV)
-        {
-            decode_mov_regmem_tofrom_reg(inst_stream, &index, output_file);
-        }
-        else if ((opcode & 0b11111110) == OPCODE_MOV_IMM_TO_REG_OR_MEM)
+        return inst_stream + inst_stream_index;
+    }
+
+    memset(padded, 0, DECODER_PADDED_SIZE);
+    memcpy(padded, inst_stream + inst_stream_index, available);
+    return padded;
+}
+
+bool decoder_decode_one(const uint8_t* const inst_stream, const uint32_t inst_stream_len, const uint32_t inst_stream_index, instruction_t* const inst)
+{
+    decoder_init();
+
+    memset(inst, 0, sizeof(instruction_t));
+    if (inst_stream_index >= inst_stream_len)
+    {
+        return false;
+    }
+
+    /* Bytes past the end are zeros, the length is checked once at the end */
+    uint8_t padded[DECODER_PADDED_SIZE];
+    const uint8_t* const bytes = decoder_get_padded(inst_stream, inst_stream_len, inst_stream_index, padded);
+    const uint32_t available = inst_stream_len - inst_stream_index;
+
+    uint32_t prefix_count = 0;
+    const opcode_info_t* info = &opcode_infos[bytes[0]];
+    const instruction_spec_t* spec;
+
+    /* Fold prefixes into the instruction that follows them */
+    while (true)
+    {
+        if (info->spec == 0)
         {
-            decode_mov_imm_to_mem(inst_stream, &index, output_file);
+            return false;
         }
-        else if ((opcode & 0b11110000) == OPCODE_MOV_IMM_TO_REG)
+        spec = &instruction_specs[info->spec - 1];
+        if (info->is_prefix == false)
         {
-            decode_mov_imm_to_reg(inst_stream, &index, output_file);
+            break;
         }
-        else if ((opcode & 0b11111110) == OPCODE_MOV_MEM_TO_ACC)
+        if (prefix_count == INSTRUCTION_MAX_PREFIX_COUNT)
         {
-            decode_mov_mem_to_acc(inst_stream, &index, output_file);
+            inst->operation = OPERATION_NONE;
+            return false;
         }
-        else if ((opcode & 0b11111110) == OPCODE_MOV_ACC_TO_MEM)
+
+        decoder_apply_prefix(spec, info, inst);
+        prefix_count++;
+        info = &opcode_infos[bytes[prefix_count]];
+    }
+
+    decoder_fetch_t fetch;
+    decoder_fetch(&fetch, bytes + prefix_count);
+    decoder_fetch_byte(&fetch);
+
+    const modrm_t* modrm = NULL;
+    if (info->has_modrm == true)
+    {
+        modrm = &modrm_table[decoder_fetch_byte(&fetch)];
+
+        /* REG is an extension of the opcode */
+        if (info->group != 0)
         {
-            decode_mov_acc_to_mem(inst_stream, &index, output_file);
+            info = &opcode_groups[info->group - 1][modrm->reg];
+            if (info->spec == 0)
+            {
+                /* A zero past the end isn't an unknown instruction, just an incomplete one */
+                if ((prefix_count + fetch.length) > available)
+                {
+                    inst->operation = spec->operation;
+                }
+                return false;
+            }
+            spec = &instruction_specs[info->spec - 1];
         }
-        else
+    }
+
+    inst->operation = spec->operation;
+    inst->w = info->w;
+
+    /* Operands are listed with REG as the destination, D=0 swaps them */
+    bool has_memory_operand = false;
+    bool has_sized_operand = false;
+    for (uint32_t i = 0; i < INSTRUCTION_OPERAND_COUNT; i++)
+    {
+        const uint8_t operand_template = spec->operands[(info->d == 1) ? i : (INSTRUCTION_OPERAND_COUNT - 1 - i)];
+        operand_t* const operand = &inst->operands[i];
+        if (decoder_decode_operand(&fetch, operand_template, info, modrm, inst, operand) == true)
         {
-            fprintf(output_file, "[DECODE] Unknown opcode (0x%02X)\n", opcode);
-            break;
+            has_sized_operand = true;
         }
+        has_memory_operand |= (operand->kind == OPERAND_MEMORY);
+    }
+
+    if (spec->flags & SPEC_FLAG_FAR)
+    {
+        inst->flags |= INSTRUCTION_FLAG_FAR;
+    }
+    else if ((has_memory_operand == true) && (has_sized_operand == false) && ((spec->flags & SPEC_FLAG_NO_SIZE) == 0))
+    {
+        inst->flags |= INSTRUCTION_FLAG_EXPLICIT_SIZE;
+    }
+    if (spec->flags & SPEC_FLAG_WIDTH_SUFFIX)
+    {
+        inst->flags |= INSTRUCTION_FLAG_WIDTH_SUFFIX;
+    }
 
-        fflush(output_file);
+    /* Check that the whole instruction was inside the stream */
+    const uint32_t length = prefix_count + fetch.length;
+    if (length > available)
+    {
+        return false;
     }
+    inst->length = (uint8_t)length;
+
+    return true;
 }
 
-void decoder_get_displacement(const uint8_t* const inst_stream, uint32_t* inst_stream_index, const bool is_16_bit, uint16_t* const displacement, bool* const displacement_is_negative)
+uint32_t decoder_decode_length(const uint8_t* const inst_stream, const uint32_t inst_stream_len, const uint32_t inst_stream_index)
 {
-    *displacement_is_negative = false;
-    *displacement = inst_stream[*inst_stream_index];
-    (*inst_stream_index)++;
-    if (is_16_bit == true)
+    decoder_init();
+
+    if (inst_stream_index >= inst_stream_len)
     {
-        *displacement |= (uint16_t)inst_stream[*inst_stream_index] << 8;
-        (*inst_stream_index)++;
+        return 0;
     }
-    else /* is_16_bit == false */
+
+    /* Bytes past the end are zeros, the length is checked once at the end */
+    uint8_t padded[DECODER_PADDED_SIZE];
+    const uint8_t* const bytes = decoder_get_padded(inst_stream, inst_stream_len, inst_stream_index, padded);
+
+    /* Skip prefixes */
+    uint32_t prefix_count = 0;
+    const opcode_info_t* info = &opcode_infos[bytes[0]];
+    while (info->is_prefix == true)
     {
-        // Sign-extend if negative
-        if (*displacement & 0x80)
+        if (prefix_count == INSTRUCTION_MAX_PREFIX_COUNT)
         {
-            *displacement |= 0xFF00;
-            *displacement_is_negative = true;
+            return 0;
         }
+        prefix_count++;
+        info = &opcode_infos[bytes[prefix_count]];
+    }
+    if (info->spec == 0)
+    {
+        return 0;
+    }
+
+    /* Only the ModR/M byte can add to the length, through the displacement and through REG selecting the instruction */
+    uint32_t length = info->length;
+    if (info->has_modrm == true)
+    {
+        const modrm_t* const modrm = &modrm_table[bytes[prefix_count + 1]];
+        if (info->group != 0)
+        {
+            info = &opcode_groups[info->group - 1][modrm->reg];
+            if (info->spec == 0)
+            {
+                return 0;
+            }
+            length = info->length;
+        }
+        length += modrm->displacement_size;
+    }
+
+    length += prefix_count;
+    if (length > (inst_stream_len - inst_stream_index))
+    {
+        return 0;
     }
+
+    return length;
 }
 
-void decoder_get_immediate(const uint8_t* const inst_stream, uint32_t* inst_stream_index, const uint8_t s, const uint8_t w, uint16_t* const immediate, bool* const immediate_is_negative)
+uint8_t decoder_get_opcode_class(const uint8_t opcode)
 {
-    *immediate_is_negative = false;
-    *immediate = inst_stream[*inst_stream_index];
-    (*inst_stream_index)++;
-    /* 16-bit value */
-    if ((s == 0) && (w == 1))
+    decoder_init();
+
+    const opcode_info_t* const info = &opcode_infos[opcode];
+    if (info->spec == 0)
     {
-        *immediate |= (uint16_t)inst_stream[*inst_stream_index] << 8;
-        (*inst_stream_index)++;
+        return DECODER_CLASS_UNKNOWN;
     }
-    else if ((s == 1) && (w == 1) && (*immediate & 0x80)) /* Sign-extend if negative */
+    if (info->is_prefix == true)
+    {
+        return DECODER_CLASS_PREFIX;
+    }
+
+    uint8_t length = info->length;
+    if (info->group != 0)
     {
-        *immediate |= 0xFF00;
-        *immediate_is_negative = true;
+        /* REG only matters for the length if the group's members differ or some are unknown */
+        const opcode_info_t* const group = opcode_groups[info->group - 1];
+        length = group[0].length;
+        for (uint32_t reg = 0; reg < OPCODE_GROUP_SIZE; reg++)
+        {
+            if ((group[reg].spec == 0) || (group[reg].length != length))
+            {
+                return DECODER_CLASS_MODRM | DECODER_CLASS_GROUP;
+            }
+        }
     }
+
+    return (uint8_t)(length | ((info->has_modrm == true) ? DECODER_CLASS_MODRM : 0));
 }
 
-const char* decoder_get_reg_name(const uint8_t w, const uint8_t reg)
+uint8_t decoder_get_unknown_opcode(const uint8_t* const inst_stream, const uint32_t inst_stream_len)
 {
-    return reg_to_reg_name[w][reg];
+    decoder_init();
+
+    uint32_t prefix_count = 0;
+    while ((prefix_count < INSTRUCTION_MAX_PREFIX_COUNT) && ((prefix_count + 1) < inst_stream_len) &&
+           (opcode_infos[inst_stream[prefix_count]].is_prefix == true))
+    {
+        prefix_count++;
+    }
+    return inst_stream[prefix_count];
 }
 
-const char* decoder_get_effective_address(const uint8_t rm)
+const modrm_t* decoder_get_modrm(const uint8_t modrm)
 {
-    return r_m_to_addr_calc_name[rm];
-}
\ No newline at end of file
+    return &modrm_table[modrm];
+}
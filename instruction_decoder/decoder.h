@@ -24,14 +24,133 @@ WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #ifndef DECODER_H
 #define DECODER_H
 
+#include "instruction.h"
+#include "output_buffer.h"
+
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
 
+/* Opcode classes, see 'decoder_get_opcode_class' */
+#define DECODER_CLASS_LENGTH_MASK (uint8_t)0x0FU  /* Length without prefixes and displacement */
+#define DECODER_CLASS_MODRM       (uint8_t)(1U << 4) /* A ModR/M byte follows the opcode */
+#define DECODER_CLASS_GROUP       (uint8_t)(1U << 5) /* REG selects the instruction and its length */
+#define DECODER_CLASS_PREFIX      (uint8_t)(1U << 6)
+#define DECODER_CLASS_UNKNOWN     (uint8_t)(1U << 7)
+
+/**
+ * Everything a ModR/M byte encodes, precomputed for all 256 values.
+*/
+typedef struct
+{
+    uint8_t mod;
+    uint8_t reg;
+    uint8_t rm;
+    uint8_t displacement_size;          /* Number of displacement bytes following the ModR/M byte */
+    bool is_register;                   /* MOD=11, R/M identifies a register */
+    bool is_direct_address;             /* MOD=00 and R/M=110, the displacement is the address */
+    uint8_t effective_address;          /* effective_address_t of the memory operand */
+    uint8_t flags;                      /* INSTRUCTION_FLAG_* the memory operand adds to the instruction */
+    const char* effective_address_name; /* Preformatted effective address without brackets or displacement */
+} modrm_t;
+
+/**
+ * @brief Build the decoder's lookup tables
+ *
+ * Decoding calls this on first use. Call it up front before decoding from several threads at once.
+*/
+void decoder_init(void);
+
+/**
+ * @brief Decode a stream of instructions and write them as assembly text
+ *
+ * @param inst_stream Stream of bytes with encoded instructions
+ * @param inst_stream_len Length of 'inst_stream' in bytes
+ * @param output_file File to write decoded instructions into
+*/
 void decoder_decode_stream(const uint8_t* const inst_stream, const uint32_t inst_stream_len, FILE* output_file);
-void decoder_get_displacement(const uint8_t* const inst_stream, uint32_t* inst_stream_index, const bool is_16_bit, uint16_t* const displacement, bool* const displacement_is_negative);
-void decoder_get_immediate(const uint8_t* const inst_stream, uint32_t* inst_stream_index, const uint8_t s, const uint8_t w, uint16_t* const immediate, bool* const immediate_is_negative);
-const char* decoder_get_reg_name(const uint8_t w, const uint8_t reg);
-const char* decoder_get_effective_address(const uint8_t rm);
+
+/**
+ * @brief Decode a stream of instructions and append them as assembly text to a buffer
+ *
+ * @param inst_stream Stream of bytes with encoded instructions
+ * @param inst_stream_len Length of 'inst_stream' in bytes
+ * @param buffer Buffer to append decoded instructions to, it's flushed when full if it has a file attached
+*/
+void decoder_decode_stream_to_buffer(const uint8_t* const inst_stream, const uint32_t inst_stream_len, output_buffer_t* const buffer);
+
+/**
+ * @brief Decode a stream of instructions in a single pass, with labels for jump and call targets
+ *
+ * Branches refer to their target by label. The text is kept in memory until the end of the stream, then the label
+ * definitions are spliced in and it's written to the file at once.
+ *
+ * @param inst_stream Stream of bytes with encoded instructions
+ * @param inst_stream_len Length of 'inst_stream' in bytes
+ * @param output_file File to write decoded instructions into
+*/
+void decoder_decode_stream_with_labels(const uint8_t* const inst_stream, const uint32_t inst_stream_len, FILE* output_file);
+
+/**
+ * @brief Decode a stream of instructions in a single pass, with labels for jump and call targets, into a buffer
+ *
+ * @param inst_stream Stream of bytes with encoded instructions
+ * @param inst_stream_len Length of 'inst_stream' in bytes
+ * @param buffer Buffer to append decoded instructions to, it's only flushed once the labels are in place
+*/
+void decoder_decode_stream_with_labels_to_buffer(const uint8_t* const inst_stream, const uint32_t inst_stream_len, output_buffer_t* const buffer);
+
+/**
+ * @brief Decode a single instruction without formatting it
+ *
+ * @param inst_stream Stream of bytes with encoded instructions
+ * @param inst_stream_len Length of 'inst_stream' in bytes
+ * @param inst_stream_index Index of the first byte of the instruction in 'inst_stream'
+ * @param inst Decoded instruction, its length tells where the next instruction starts
+ * @return false if the opcode is unknown or the instruction runs past the end of the stream
+*/
+bool decoder_decode_one(const uint8_t* const inst_stream, const uint32_t inst_stream_len, const uint32_t inst_stream_index, instruction_t* const inst);
+
+/**
+ * @brief Get the length of a single instruction without decoding its operands
+ *
+ * Only the prefixes, the opcode and the ModR/M byte are looked at, which makes this much cheaper than
+ * 'decoder_decode_one'.
+ *
+ * @param inst_stream Stream of bytes with encoded instructions
+ * @param inst_stream_len Length of 'inst_stream' in bytes
+ * @param inst_stream_index Index of the first byte of the instruction in 'inst_stream'
+ * @return Length of the instruction in bytes, 0 if the opcode is unknown or the instruction runs past the end of the
+ *         stream
+*/
+uint32_t decoder_decode_length(const uint8_t* const inst_stream, const uint32_t inst_stream_len, const uint32_t inst_stream_index);
+
+/**
+ * @brief Classify a byte as the first byte of an instruction
+ *
+ * A plain class holds the length of the instruction without displacement and whether a ModR/M byte follows, which is
+ * all that's needed to find the next instruction. Prefixes, unknown opcodes and groups whose members differ in length
+ * are flagged, their length needs 'decoder_decode_length'.
+ *
+ * @param opcode First byte of the instruction
+ * @return DECODER_CLASS_* flags and length
+*/
+uint8_t decoder_get_opcode_class(const uint8_t opcode);
+
+/**
+ * @brief Get the opcode of an instruction that failed to decode as an unknown opcode
+ *
+ * Prefixes are folded into the instruction, so the opcode is the first byte after them.
+ *
+ * @param inst_stream Bytes of the instruction
+ * @param inst_stream_len Number of bytes available
+ * @return The opcode byte to report
+*/
+uint8_t decoder_get_unknown_opcode(const uint8_t* const inst_stream, const uint32_t inst_stream_len);
+
+/**
+ * @brief Get the precomputed fields of a ModR/M byte
+*/
+const modrm_t* decoder_get_modrm(const uint8_t modrm);
 
 #endif
@@ -0,0 +1,242 @@
+/*
+Copyright (c) 2023 Daniel Fedai Larsen
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "decoder_batch.h"
+
+#include "decoder.h"
+#include "decoder_stream.h"
+#include "encoder.h"
+#include "file_view.h"
+#include "thread.h"
+
+#include <stdbool.h>
+#include <stdlib.h>
+
+typedef struct
+{
+    const char* const* paths;
+    uint32_t path_count;
+    volatile uint32_t next_path;    /* Index of the next file to take, shared by all workers */
+    decoder_batch_result_t* results;
+} decoder_batch_t;
+
+typedef struct
+{
+    decoder_batch_t* batch;
+    thread_t thread;
+} decoder_batch_worker_t;
+
+static void decoder_batch_count_instruction(void* const context, const uint64_t offset, const instruction_t* const inst)
+{
+    (void)offset;
+    (void)inst;
+    ((decoder_batch_result_t*)context)->inst_count++;
+}
+
+static void decoder_batch_process_file(decoder_batch_result_t* const result)
+{
+    result->size = 0;
+    result->error_offset = 0;
+    result->inst_count = 0;
+
+    file_view_t view;
+    if (file_view_open(&view, result->path) == false)
+    {
+        result->status = DECODER_BATCH_STATUS_OPEN_FAILED;
+        return;
+    }
+    result->size = view.size;
+    if (view.size > UINT32_MAX)
+    {
+        result->status = DECODER_BATCH_STATUS_TOO_LARGE;
+        file_view_close(&view);
+        return;
+    }
+
+    /* Decode without text, only the instructions are counted */
+    decoder_stream_t stream;
+    decoder_stream_init(&stream, NULL);
+    stream.record = decoder_batch_count_instruction;
+    stream.record_context = result;
+    decoder_stream_feed(&stream, view.data, (uint32_t)view.size);
+    if (decoder_stream_finish(&stream) == false)
+    {
+        result->status = DECODER_BATCH_STATUS_DECODE_FAILED;
+        result->error_offset = stream.offset;
+        result->inst_count = 0;
+        file_view_close(&view);
+        return;
+    }
+
+    /* Encode again and compare with the original */
+    uint32_t mismatch_offset;
+    if (encoder_verify_stream(view.data, (uint32_t)view.size, &mismatch_offset) == false)
+    {
+        result->status = DECODER_BATCH_STATUS_MISMATCH;
+        result->error_offset = mismatch_offset;
+    }
+    else
+    {
+        result->status = DECODER_BATCH_STATUS_OK;
+    }
+
+    file_view_close(&view);
+}
+
+static void decoder_batch_work(void* argument)
+{
+    decoder_batch_worker_t* const worker = (decoder_batch_worker_t*)argument;
+    decoder_batch_t* const batch = worker->batch;
+
+    uint32_t path_index;
+    while ((path_index = thread_atomic_increment(&batch->next_path)) < batch->path_count)
+    {
+        decoder_batch_process_file(&batch->results[path_index]);
+    }
+}
+
+void decoder_batch_run(const char* const* const paths, const uint32_t path_count, uint32_t thread_count, decoder_batch_result_t* const results)
+{
+    /* Make sure the workers don't race to build the tables */
+    decoder_init();
+    encoder_init();
+
+    if (thread_count == 0)
+    {
+        thread_count = thread_get_processor_count();
+    }
+    if (thread_count > path_count)
+    {
+        thread_count = path_count;
+    }
+    if (thread_count == 0)
+    {
+        return;
+    }
+
+    decoder_batch_t batch;
+    batch.paths = paths;
+    batch.path_count = path_count;
+    batch.next_path = 0;
+    batch.results = results;
+    for (uint32_t i = 0; i < path_count; i++)
+    {
+        results[i].path = paths[i];
+    }
+
+    decoder_batch_worker_t* workers = calloc(thread_count, sizeof(decoder_batch_worker_t));
+    for (uint32_t i = 0; i < thread_count; i++)
+    {
+        workers[i].batch = &batch;
+    }
+    for (uint32_t i = 1; i < thread_count; i++)
+    {
+        if (thread_create(&workers[i].thread, decoder_batch_work, &workers[i]) == false)
+        {
+            /* The other workers pick up its share */
+            workers[i].thread.function = NULL;
+        }
+    }
+    decoder_batch_work(&workers[0]);
+    for (uint32_t i = 0; i < thread_count; i++)
+    {
+        if ((i > 0) && (workers[i].thread.function != NULL))
+        {
+            thread_join(&workers[i].thread);
+        }
+    }
+    free(workers);
+}
+
+uint32_t decoder_batch_format_results(const decoder_batch_result_t* const results, const uint32_t result_count, output_buffer_t* const buffer)
+{
+    uint32_t failed_count = 0;
+    uint64_t total_size = 0;
+    uint64_t total_inst_count = 0;
+    for (uint32_t i = 0; i < result_count; i++)
+    {
+        const decoder_batch_result_t* const result = &results[i];
+        total_size += result->size;
+        total_inst_count += result->inst_count;
+        failed_count += result->status != DECODER_BATCH_STATUS_OK;
+
+        switch (result->status)
+        {
+            case DECODER_BATCH_STATUS_OK:
+            {
+                output_buffer_append_string(buffer, "[OK] ");
+                output_buffer_append_string(buffer, result->path);
+                output_buffer_append_string(buffer, " (");
+                output_buffer_append_uint(buffer, result->inst_count);
+                output_buffer_append_string(buffer, " instructions)\n");
+                break;
+            }
+            case DECODER_BATCH_STATUS_OPEN_FAILED:
+            {
+                output_buffer_append_string(buffer, "[FILE] ");
+                output_buffer_append_string(buffer, result->path);
+                output_buffer_append_string(buffer, ": failed to open file\n");
+                break;
+            }
+            case DECODER_BATCH_STATUS_TOO_LARGE:
+            {
+                output_buffer_append_string(buffer, "[FILE] ");
+                output_buffer_append_string(buffer, result->path);
+                output_buffer_append_string(buffer, ": file is too large\n");
+                break;
+            }
+            case DECODER_BATCH_STATUS_DECODE_FAILED:
+            {
+                output_buffer_append_string(buffer, "[DECODE] ");
+                output_buffer_append_string(buffer, result->path);
+                output_buffer_append_string(buffer, ": unknown or truncated instruction at offset ");
+                output_buffer_append_uint(buffer, (uint32_t)result->error_offset);
+                output_buffer_append_char(buffer, '\n');
+                break;
+            }
+            case DECODER_BATCH_STATUS_MISMATCH:
+            {
+                output_buffer_append_string(buffer, "[COMPARE] ");
+                output_buffer_append_string(buffer, result->path);
+                output_buffer_append_string(buffer, ": instruction at offset ");
+                output_buffer_append_uint(buffer, (uint32_t)result->error_offset);
+                output_buffer_append_string(buffer, " doesn't encode back to the original bytes\n");
+                break;
+            }
+        }
+    }
+
+    /* Summary */
+    output_buffer_append_char(buffer, '\n');
+    output_buffer_append_uint(buffer, result_count);
+    output_buffer_append_string(buffer, " files, ");
+    output_buffer_append_uint(buffer, result_count - failed_count);
+    output_buffer_append_string(buffer, " passed, ");
+    output_buffer_append_uint(buffer, failed_count);
+    output_buffer_append_string(buffer, " failed\n");
+    char totals[64];
+    snprintf(totals, sizeof(totals), "%llu bytes, %llu instructions\n", (unsigned long long)total_size, (unsigned long long)total_inst_count);
+    output_buffer_append_string(buffer, totals);
+
+    return failed_count;
+}
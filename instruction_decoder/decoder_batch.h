@@ -0,0 +1,70 @@
+/*
+Copyright (c) 2023 Daniel Fedai Larsen
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef DECODER_BATCH_H
+#define DECODER_BATCH_H
+
+#include "output_buffer.h"
+
+#include <stdint.h>
+
+typedef enum
+{
+    DECODER_BATCH_STATUS_OK,
+    DECODER_BATCH_STATUS_OPEN_FAILED,
+    DECODER_BATCH_STATUS_TOO_LARGE,
+    DECODER_BATCH_STATUS_DECODE_FAILED, /* Unknown opcode or truncated instruction at 'error_offset' */
+    DECODER_BATCH_STATUS_MISMATCH,      /* Instruction at 'error_offset' doesn't encode back to the same bytes */
+} decoder_batch_status_t;
+
+typedef struct
+{
+    const char* path;
+    decoder_batch_status_t status;
+    uint64_t size;
+    uint64_t error_offset;
+    uint32_t inst_count;
+} decoder_batch_result_t;
+
+/**
+ * @brief Decode and verify many files on a pool of threads. Workers take the next file from a shared counter, so a
+ * few large files don't hold up the rest, and each worker reuses its own output buffer for every file it decodes.
+ *
+ * @param paths Files to process
+ * @param path_count Number of files in 'paths'
+ * @param thread_count Number of threads to use, 0 to use one per processor
+ * @param results Receives one result per file, in the same order as 'paths'
+*/
+void decoder_batch_run(const char* const* const paths, const uint32_t path_count, uint32_t thread_count, decoder_batch_result_t* const results);
+
+/**
+ * @brief Write one line per file and a summary of all of them
+ *
+ * @param results Results from decoder_batch_run()
+ * @param result_count Number of results
+ * @param buffer Buffer to write to
+ * @return Number of files that failed
+*/
+uint32_t decoder_batch_format_results(const decoder_batch_result_t* const results, const uint32_t result_count, output_buffer_t* const buffer);
+
+#endif
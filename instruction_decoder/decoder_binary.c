@@ -0,0 +1,188 @@
+/*
+Copyright (c) 2023 Daniel Fedai Larsen
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "decoder_binary.h"
+
+#include "decoder.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/* Instructions average about three bytes, start with room for that many */
+#define DECODER_BINARY_BYTES_PER_INSTRUCTION 3U
+#define DECODER_BINARY_MIN_CAPACITY 64U
+
+/* Consumers rely on the record size, fail the build if padding changes it */
+typedef char decoder_binary_record_size_check[(sizeof(decoder_binary_record_t) == 16) ? 1 : -1];
+typedef char decoder_binary_header_size_check[(sizeof(decoder_binary_header_t) == 32) ? 1 : -1];
+
+void decoder_binary_init(decoder_binary_t* const binary)
+{
+    memset(&binary->header, 0, sizeof(decoder_binary_header_t));
+    binary->header.magic = DECODER_BINARY_MAGIC;
+    binary->header.version = DECODER_BINARY_VERSION;
+    binary->header.header_size = sizeof(decoder_binary_header_t);
+    binary->header.record_size = sizeof(decoder_binary_record_t);
+    binary->records = NULL;
+    binary->capacity = 0;
+}
+
+void decoder_binary_free(decoder_binary_t* const binary)
+{
+    free(binary->records);
+    binary->records = NULL;
+    binary->capacity = 0;
+    binary->header.record_count = 0;
+}
+
+bool decoder_binary_build(decoder_binary_t* const binary, const uint8_t* const inst_stream, const uint32_t inst_stream_len)
+{
+    const uint32_t wanted_capacity = (inst_stream_len / DECODER_BINARY_BYTES_PER_INSTRUCTION) + DECODER_BINARY_MIN_CAPACITY;
+    if (binary->capacity < wanted_capacity)
+    {
+        binary->capacity = wanted_capacity;
+        binary->records = realloc(binary->records, binary->capacity * sizeof(decoder_binary_record_t));
+    }
+
+    uint32_t count = 0;
+    uint32_t offset = 0;
+    instruction_t inst;
+    while ((offset < inst_stream_len) && (decoder_decode_one(inst_stream, inst_stream_len, offset, &inst) == true))
+    {
+        if (count == binary->capacity)
+        {
+            binary->capacity *= 2;
+            binary->records = realloc(binary->records, binary->capacity * sizeof(decoder_binary_record_t));
+        }
+
+        decoder_binary_record_t* const record = &binary->records[count];
+        record->offset = offset;
+        record->operation = inst.operation;
+        record->length = inst.length;
+        record->flags = (uint16_t)((inst.flags & DECODER_BINARY_RECORD_INSTRUCTION_FLAGS_MASK) |
+                                   (((inst.segment - REGISTER_ES) & 0x3) << DECODER_BINARY_RECORD_SEGMENT_SHIFT) |
+                                   (inst.w << DECODER_BINARY_RECORD_W_SHIFT));
+        record->operands[0] = inst.operands[0];
+        record->operands[1] = inst.operands[1];
+        record->displacement = inst.displacement;
+        record->immediate = inst.immediate;
+
+        offset += inst.length;
+        count++;
+    }
+
+    binary->header.record_count = count;
+    binary->header.stream_len = inst_stream_len;
+    binary->header.end = offset;
+    binary->header.flags = (offset < inst_stream_len) ? DECODER_BINARY_FLAG_INCOMPLETE : 0;
+    return offset == inst_stream_len;
+}
+
+bool decoder_binary_write(const decoder_binary_t* const binary, FILE* file)
+{
+    if (fwrite(&binary->header, sizeof(decoder_binary_header_t), 1, file) != 1)
+    {
+        return false;
+    }
+
+    const uint32_t count = binary->header.record_count;
+    return (count == 0) || (fwrite(binary->records, sizeof(decoder_binary_record_t), count, file) == count);
+}
+
+const decoder_binary_record_t* decoder_binary_get_records(const uint8_t* const data, const uint64_t size, const decoder_binary_header_t** const header)
+{
+    if (size < sizeof(decoder_binary_header_t))
+    {
+        return NULL;
+    }
+
+    const decoder_binary_header_t* const found = (const decoder_binary_header_t*)data;
+    if ((found->magic != DECODER_BINARY_MAGIC) ||
+        (found->version != DECODER_BINARY_VERSION) ||
+        (found->header_size < sizeof(decoder_binary_header_t)) ||
+        (found->record_size != sizeof(decoder_binary_record_t)) ||
+        (found->header_size > size) ||
+        (((size - found->header_size) / found->record_size) < found->record_count))
+    {
+        return NULL;
+    }
+
+    *header = found;
+    return (const decoder_binary_record_t*)(data + found->header_size);
+}
+
+/**
+ * Check that an operand only holds values the formatter can look up.
+*/
+static bool decoder_binary_is_valid_operand(const operand_t* const operand)
+{
+    switch (operand->kind)
+    {
+        case OPERAND_NONE:
+        case OPERAND_IMMEDIATE:
+        case OPERAND_RELATIVE:
+        case OPERAND_FAR_POINTER:
+        {
+            return true;
+        }
+        case OPERAND_REGISTER:
+        {
+            return operand->value < REGISTER_COUNT;
+        }
+        case OPERAND_MEMORY:
+        {
+            return operand->value < EFFECTIVE_ADDRESS_COUNT;
+        }
+        default:
+        {
+            return false;
+        }
+    }
+}
+
+bool decoder_binary_get_instruction(const decoder_binary_record_t* const record, instruction_t* const inst)
+{
+    if ((record->operation >= OPERATION_COUNT) ||
+        (record->length == 0) ||
+        (record->length > INSTRUCTION_MAX_LENGTH) ||
+        (decoder_binary_is_valid_operand(&record->operands[0]) == false) ||
+        (decoder_binary_is_valid_operand(&record->operands[1]) == false))
+    {
+        return false;
+    }
+
+    inst->operation = record->operation;
+    inst->length = record->length;
+    inst->w = (uint8_t)(record->flags >> DECODER_BINARY_RECORD_W_SHIFT);
+    inst->flags = record->flags & DECODER_BINARY_RECORD_INSTRUCTION_FLAGS_MASK;
+    inst->segment = 0;
+    if ((inst->flags & INSTRUCTION_FLAG_SEGMENT_OVERRIDE) != 0)
+    {
+        inst->segment = (uint8_t)(REGISTER_ES + ((record->flags >> DECODER_BINARY_RECORD_SEGMENT_SHIFT) & 0x3));
+    }
+    inst->operands[0] = record->operands[0];
+    inst->operands[1] = record->operands[1];
+    inst->displacement = record->displacement;
+    inst->immediate = record->immediate;
+    return true;
+}
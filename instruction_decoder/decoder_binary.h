@@ -0,0 +1,136 @@
+/*
+Copyright (c) 2023 Daniel Fedai Larsen
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef DECODER_BINARY_H
+#define DECODER_BINARY_H
+
+#include "instruction.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/* Identifies a binary listing, followed by the format version */
+#define DECODER_BINARY_MAGIC 0x4E494238U /* "8BIN" */
+#define DECODER_BINARY_VERSION 1U
+
+/* Decoding stopped at an unknown opcode or a truncated instruction at 'end' */
+#define DECODER_BINARY_FLAG_INCOMPLETE (uint16_t)(1U << 0)
+
+/* A record's 'flags' hold the INSTRUCTION_FLAG_* bits, the segment override and W */
+#define DECODER_BINARY_RECORD_INSTRUCTION_FLAGS_MASK (uint16_t)0x1FFFU
+#define DECODER_BINARY_RECORD_SEGMENT_SHIFT 13U /* 2 bits, segment register - REGISTER_ES */
+#define DECODER_BINARY_RECORD_W_SHIFT 15U
+
+/**
+ * Start of a binary listing, 'record_count' records follow it. Values are in the byte order of the machine that wrote
+ * it, a machine with a different byte order sees a bad magic number.
+*/
+typedef struct
+{
+    uint32_t magic;         /* DECODER_BINARY_MAGIC */
+    uint16_t version;       /* DECODER_BINARY_VERSION */
+    uint16_t header_size;   /* Offset of the first record */
+    uint16_t record_size;   /* Size of each record */
+    uint16_t flags;         /* DECODER_BINARY_FLAG_* */
+    uint32_t record_count;
+    uint32_t stream_len;    /* Length of the decoded stream */
+    uint32_t end;           /* Offset where decoding stopped, 'stream_len' unless the listing is incomplete */
+    uint8_t reserved[8];
+} decoder_binary_header_t;
+
+/**
+ * One decoded instruction. Records have a fixed size and hold no pointers, so a listing can be mapped and used in place.
+*/
+typedef struct
+{
+    uint32_t offset;                                /* Offset of the first byte of the instruction, prefixes included */
+    uint8_t operation;                              /* operation_t */
+    uint8_t length;                                 /* Encoded length in bytes */
+    uint16_t flags;                                 /* See DECODER_BINARY_RECORD_* */
+    operand_t operands[INSTRUCTION_OPERAND_COUNT];  /* Destination followed by source */
+    uint16_t displacement;
+    uint16_t immediate;
+} decoder_binary_record_t;
+
+/**
+ * Binary listing of a stream, kept in memory.
+*/
+typedef struct
+{
+    decoder_binary_header_t header;
+    decoder_binary_record_t* records;
+    uint32_t capacity;
+} decoder_binary_t;
+
+/**
+ * @brief Initialize an empty listing
+*/
+void decoder_binary_init(decoder_binary_t* const binary);
+
+/**
+ * @brief Free the records of a listing
+*/
+void decoder_binary_free(decoder_binary_t* const binary);
+
+/**
+ * @brief Decode a stream into records, replacing the records already in the listing
+ *
+ * @param binary Listing to fill, the record storage is kept between calls
+ * @param inst_stream Stream of bytes with encoded instructions
+ * @param inst_stream_len Length of 'inst_stream' in bytes
+ * @return false if decoding stopped before the end of the stream
+*/
+bool decoder_binary_build(decoder_binary_t* const binary, const uint8_t* const inst_stream, const uint32_t inst_stream_len);
+
+/**
+ * @brief Write a listing to a file
+ *
+ * @param binary Listing to write
+ * @param file File opened in binary mode
+ * @return false if the file couldn't be written
+*/
+bool decoder_binary_write(const decoder_binary_t* const binary, FILE* file);
+
+/**
+ * @brief Check the header of a listing held in memory, e.g. a mapped file, and find its records
+ *
+ * @param data Start of the listing
+ * @param size Size of the listing in bytes
+ * @param header Receives the header
+ * @return First record, NULL if the header is invalid or the records don't fit in 'size'
+*/
+const decoder_binary_record_t* decoder_binary_get_records(const uint8_t* const data, const uint64_t size, const decoder_binary_header_t** const header);
+
+/**
+ * @brief Turn a record back into the decoded instruction
+ *
+ * A listing may come from anywhere, so the record is checked before anything in it is used to look up names.
+ *
+ * @param record Record from a listing
+ * @param inst Receives the instruction
+ * @return false if the record holds an operation, operand or length the decoder can't produce
+*/
+bool decoder_binary_get_instruction(const decoder_binary_record_t* const record, instruction_t* const inst);
+
+#endif
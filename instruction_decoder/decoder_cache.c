@@ -0,0 +1,135 @@
+/*
+Copyright (c) 2023 Daniel Fedai Larsen
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "decoder_cache.h"
+
+#include "decoder.h"
+#include "decoder_format.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* The key holds the first eight bytes of an instruction and 'tail' the ninth */
+typedef char decoder_cache_key_size_check[(INSTRUCTION_MAX_LENGTH <= (sizeof(uint64_t) + 1)) ? 1 : -1];
+
+/* Fibonacci hashing, the top bits of the product depend on every bit of the key */
+#define DECODER_CACHE_HASH_MULTIPLIER 0x9E3779B97F4A7C15ULL
+
+void decoder_cache_init(decoder_cache_t* const cache, const uint32_t capacity)
+{
+    cache->capacity = 2;
+    cache->shift = 63;
+    while (cache->capacity < ((capacity > 0) ? capacity : DECODER_CACHE_DEFAULT_CAPACITY))
+    {
+        cache->capacity *= 2;
+        cache->shift--;
+    }
+    cache->entries = calloc(cache->capacity, sizeof(decoder_cache_entry_t));
+    cache->texts = malloc((size_t)cache->capacity * DECODER_CACHE_TEXT_MAX);
+    cache->count = 0;
+    cache->lookups = 0;
+    cache->hits = 0;
+    cache->evictions = 0;
+}
+
+void decoder_cache_free(decoder_cache_t* const cache)
+{
+    free(cache->entries);
+    free(cache->texts);
+    cache->entries = NULL;
+    cache->texts = NULL;
+    cache->capacity = 0;
+    cache->count = 0;
+}
+
+bool decoder_cache_decode(decoder_cache_t* const cache, const uint8_t* const inst_stream, const uint32_t inst_stream_len, const uint32_t inst_stream_index, instruction_t* const inst, output_buffer_t* const buffer)
+{
+    /* The key is the instruction's bytes, so its length is needed first */
+    const uint32_t length = decoder_decode_length(inst_stream, inst_stream_len, inst_stream_index);
+    if (length == 0)
+    {
+        /* Let the full decoder tell an unknown opcode from a truncated instruction */
+        decoder_decode_one(inst_stream, inst_stream_len, inst_stream_index, inst);
+        return false;
+    }
+
+    const uint8_t* const bytes = inst_stream + inst_stream_index;
+    const uint32_t key_len = (length < sizeof(uint64_t)) ? length : sizeof(uint64_t);
+    uint64_t key = 0;
+    for (uint32_t i = 0; i < key_len; i++)
+    {
+        key |= (uint64_t)bytes[i] << (i * 8);
+    }
+    const uint16_t tail = (uint16_t)(length | ((length > sizeof(key)) ? (bytes[sizeof(key)] << 8) : 0));
+
+    const uint32_t slot = (uint32_t)(((key ^ tail) * DECODER_CACHE_HASH_MULTIPLIER) >> cache->shift);
+    decoder_cache_entry_t* const entry = &cache->entries[slot];
+    char* const text = cache->texts + ((size_t)slot * DECODER_CACHE_TEXT_MAX);
+    cache->lookups++;
+    if ((entry->key == key) && (entry->tail == tail))
+    {
+        cache->hits++;
+        *inst = entry->inst;
+        output_buffer_append(buffer, text, entry->text_len);
+        return true;
+    }
+
+    /* Miss, format straight into the buffer and copy the line from there, reserving first so a flush can't split it */
+    decoder_decode_one(inst_stream, inst_stream_len, inst_stream_index, inst);
+    output_buffer_reserve(buffer, DECODER_FORMAT_LINE_MAX);
+    const uint32_t text_start = buffer->size;
+    decoder_format_instruction(inst, buffer);
+    const uint32_t text_len = buffer->size - text_start;
+    if (text_len > DECODER_CACHE_TEXT_MAX)
+    {
+        return true;
+    }
+
+    if (entry->tail == 0)
+    {
+        cache->count++;
+    }
+    else /* Another encoding had the entry */
+    {
+        cache->evictions++;
+    }
+    entry->key = key;
+    entry->tail = tail;
+    entry->text_len = (uint8_t)text_len;
+    entry->inst = *inst;
+    memcpy(text, buffer->data + text_start, text_len);
+
+    return true;
+}
+
+void decoder_cache_format_stats(const decoder_cache_t* const cache, output_buffer_t* const buffer)
+{
+    const double hit_rate = (cache->lookups > 0) ? ((100.0 * (double)cache->hits) / (double)cache->lookups) : 0.0;
+
+    char message[160];
+    snprintf(message, sizeof(message), "[CACHE] Lookups %llu, hits %llu (%.1f%%), entries %u/%u, evictions %llu\n",
+             (unsigned long long)cache->lookups, (unsigned long long)cache->hits, hit_rate, cache->count, cache->capacity,
+             (unsigned long long)cache->evictions);
+    output_buffer_append_string(buffer, message);
+}
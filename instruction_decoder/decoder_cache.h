@@ -0,0 +1,99 @@
+/*
+Copyright (c) 2023 Daniel Fedai Larsen
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef DECODER_CACHE_H
+#define DECODER_CACHE_H
+
+#include "instruction.h"
+#include "output_buffer.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Number of entries, must be a power of two */
+#define DECODER_CACHE_DEFAULT_CAPACITY 4096U
+/* Longest line of text kept in an entry, longer lines are formatted every time */
+#define DECODER_CACHE_TEXT_MAX 64U
+
+/**
+ * A decoded instruction keyed by the bytes it was decoded from. Its text is kept apart in 'decoder_cache_t::texts', the
+ * text only depends on the bytes, jump targets are written relative to the instruction.
+*/
+typedef struct
+{
+    uint64_t key;       /* First eight bytes of the instruction, zero padded */
+    uint16_t tail;      /* Length of the instruction and its ninth byte above it, 0 for an empty entry */
+    uint8_t text_len;
+    instruction_t inst;
+} decoder_cache_entry_t;
+
+/**
+ * Direct-mapped table of decoded instructions. Repeated encodings are decoded and formatted once, later occurrences
+ * cost a length scan, one probe and a copy of the text. Entries are kept small so the default table fits in L2, a miss
+ * costs about as much as decoding without the cache plus the scan and the copy into the entry.
+*/
+typedef struct
+{
+    decoder_cache_entry_t* entries;
+    char* texts;         /* DECODER_CACHE_TEXT_MAX bytes for each entry, only read on a hit */
+    uint32_t capacity;
+    uint32_t shift;      /* Turns a 64-bit hash into an entry number */
+    uint32_t count;      /* Entries in use */
+    uint64_t lookups;
+    uint64_t hits;
+    uint64_t evictions;  /* Entries replaced by another encoding with the same hash */
+} decoder_cache_t;
+
+/**
+ * @brief Allocate an empty cache
+ *
+ * @param cache Cache to initialize
+ * @param capacity Number of entries, rounded up to a power of two of at least 2, 0 for DECODER_CACHE_DEFAULT_CAPACITY
+*/
+void decoder_cache_init(decoder_cache_t* const cache, const uint32_t capacity);
+
+/**
+ * @brief Free the entries of a cache
+*/
+void decoder_cache_free(decoder_cache_t* const cache);
+
+/**
+ * @brief Decode a single instruction and append its text, taking both from the cache when the bytes were seen before
+ *
+ * @param cache Cache to look in and add to
+ * @param inst_stream Stream of bytes with encoded instructions
+ * @param inst_stream_len Length of 'inst_stream' in bytes
+ * @param inst_stream_index Index of the first byte of the instruction in 'inst_stream'
+ * @param inst Decoded instruction
+ * @param buffer Buffer to append the formatted instruction to
+ * @return false, with nothing appended, if the opcode is unknown or the instruction runs past the end of the stream.
+ *         'inst' tells the two apart like for 'decoder_decode_one'
+*/
+bool decoder_cache_decode(decoder_cache_t* const cache, const uint8_t* const inst_stream, const uint32_t inst_stream_len, const uint32_t inst_stream_index, instruction_t* const inst, output_buffer_t* const buffer);
+
+/**
+ * @brief Write the hit rate and occupancy of a cache as a line of text
+*/
+void decoder_cache_format_stats(const decoder_cache_t* const cache, output_buffer_t* const buffer);
+
+#endif
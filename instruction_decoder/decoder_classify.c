@@ -0,0 +1,267 @@
+/*
+Copyright (c) 2023 Daniel Fedai Larsen
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "decoder_classify.h"
+
+#include "cpu.h"
+#include "decoder.h"
+
+#include <stdbool.h>
+
+#if defined(CPU_X86)
+#include <immintrin.h>
+#endif
+
+#if defined(CPU_X86) && (defined(__GNUC__) || defined(__clang__))
+#define DECODER_CLASSIFY_TARGET(isa) __attribute__((target(isa)))
+#else
+#define DECODER_CLASSIFY_TARGET(isa)
+#endif
+
+#define OPCODE_COUNT 256U
+#define NIBBLE_COUNT 16U
+
+typedef void (*decoder_classify_function_t)(const uint8_t* const bytes, const uint32_t count, uint8_t* const classes);
+
+/* Class of every byte */
+static uint8_t class_table[OPCODE_COUNT];
+/* The class table as differences between rows of 16 classes, see 'decoder_classify_ssse3' */
+static uint8_t class_deltas[NIBBLE_COUNT][NIBBLE_COUNT];
+static uint8_t class_delta_biases[NIBBLE_COUNT];
+static uint32_t class_delta_count;
+static uint32_t class_delta_upper; /* First delta for the upper half of the table */
+/* Displacement bytes that follow each ModR/M byte */
+static uint8_t displacement_sizes[OPCODE_COUNT];
+
+static decoder_classify_function_t classify_function = NULL;
+static const char* classify_implementation = "scalar";
+
+static void decoder_classify_scalar(const uint8_t* const bytes, const uint32_t count, uint8_t* const classes)
+{
+    for (uint32_t i = 0; i < count; i++)
+    {
+        classes[i] = class_table[bytes[i]];
+    }
+}
+
+#if defined(CPU_X86)
+
+/**
+ * Table lookup with shuffles, 16 bytes at a time. A shuffle looks up 16 entries, so the 256 classes take a shuffle for
+ * each row of 16 (one high nibble). A split into one low and one high nibble lookup can't express the 8086 classes.
+ *
+ * A saturating add of 0x70 - 16 * R keeps bit 7, which makes a shuffle return 0, clear only for bytes in rows 0 to R,
+ * and keeps their low nibble. Shuffling row R XOR row R + 1 with it and XORing rows 7 down to 0 leaves every byte with
+ * its own row. The upper half does the same with bit 7 of the input flipped. Rows equal to the next one drop out, which
+ * leaves 13 rows: 39 adds, shuffles and XORs per vector. Without VEX a shuffle overwrites its table, so this path also
+ * copies a table per row and is slower than the scalar lookup on CPUs that have AVX2, it's only picked without it.
+*/
+DECODER_CLASSIFY_TARGET("ssse3")
+static void decoder_classify_ssse3(const uint8_t* const bytes, const uint32_t count, uint8_t* const classes)
+{
+    const __m128i upper_flip = _mm_set1_epi8((char)0x80);
+    __m128i deltas[NIBBLE_COUNT];
+    __m128i biases[NIBBLE_COUNT];
+    for (uint32_t delta = 0; delta < class_delta_count; delta++)
+    {
+        deltas[delta] = _mm_loadu_si128((const __m128i*)class_deltas[delta]);
+        biases[delta] = _mm_set1_epi8((char)class_delta_biases[delta]);
+    }
+
+    uint32_t i = 0;
+    for (; (i + 16) <= count; i += 16)
+    {
+        const __m128i input = _mm_loadu_si128((const __m128i*)(bytes + i));
+        const __m128i upper_input = _mm_xor_si128(input, upper_flip);
+        __m128i result = _mm_setzero_si128();
+        uint32_t delta = 0;
+        for (; delta < class_delta_upper; delta++)
+        {
+            const __m128i index = _mm_adds_epu8(input, biases[delta]);
+            result = _mm_xor_si128(result, _mm_shuffle_epi8(deltas[delta], index));
+        }
+        for (; delta < class_delta_count; delta++)
+        {
+            const __m128i index = _mm_adds_epu8(upper_input, biases[delta]);
+            result = _mm_xor_si128(result, _mm_shuffle_epi8(deltas[delta], index));
+        }
+        _mm_storeu_si128((__m128i*)(classes + i), result);
+    }
+
+    decoder_classify_scalar(bytes + i, count - i, classes + i);
+}
+
+/**
+ * The same as 'decoder_classify_ssse3' 32 bytes at a time, the shuffle works on each 16-byte lane so every delta is in
+ * both lanes.
+*/
+DECODER_CLASSIFY_TARGET("avx2")
+static void decoder_classify_avx2(const uint8_t* const bytes, const uint32_t count, uint8_t* const classes)
+{
+    const __m256i upper_flip = _mm256_set1_epi8((char)0x80);
+    __m256i deltas[NIBBLE_COUNT];
+    __m256i biases[NIBBLE_COUNT];
+    for (uint32_t delta = 0; delta < class_delta_count; delta++)
+    {
+        deltas[delta] = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)class_deltas[delta]));
+        biases[delta] = _mm256_set1_epi8((char)class_delta_biases[delta]);
+    }
+
+    uint32_t i = 0;
+    for (; (i + 32) <= count; i += 32)
+    {
+        const __m256i input = _mm256_loadu_si256((const __m256i*)(bytes + i));
+        const __m256i upper_input = _mm256_xor_si256(input, upper_flip);
+        __m256i result = _mm256_setzero_si256();
+        uint32_t delta = 0;
+        for (; delta < class_delta_upper; delta++)
+        {
+            const __m256i index = _mm256_adds_epu8(input, biases[delta]);
+            result = _mm256_xor_si256(result, _mm256_shuffle_epi8(deltas[delta], index));
+        }
+        for (; delta < class_delta_count; delta++)
+        {
+            const __m256i index = _mm256_adds_epu8(upper_input, biases[delta]);
+            result = _mm256_xor_si256(result, _mm256_shuffle_epi8(deltas[delta], index));
+        }
+        _mm256_storeu_si256((__m256i*)(classes + i), result);
+    }
+
+    decoder_classify_scalar(bytes + i, count - i, classes + i);
+}
+
+#endif
+
+void decoder_classify_init(void)
+{
+    if (classify_function != NULL)
+    {
+        return;
+    }
+
+    for (uint32_t opcode = 0; opcode < OPCODE_COUNT; opcode++)
+    {
+        class_table[opcode] = decoder_get_opcode_class((uint8_t)opcode);
+        displacement_sizes[opcode] = decoder_get_modrm((uint8_t)opcode)->displacement_size;
+    }
+
+    /* Rows 7 and 15 end their half and are kept whole, a row equal to the next one has nothing to add */
+    class_delta_count = 0;
+    for (uint32_t row = 0; row < NIBBLE_COUNT; row++)
+    {
+        if (row == (NIBBLE_COUNT / 2))
+        {
+            class_delta_upper = class_delta_count;
+        }
+
+        const bool is_last_in_half = (row % (NIBBLE_COUNT / 2)) == ((NIBBLE_COUNT / 2) - 1);
+        bool is_empty = true;
+        for (uint32_t column = 0; column < NIBBLE_COUNT; column++)
+        {
+            const uint8_t next = (is_last_in_half == true) ? 0 : class_table[((row + 1) * NIBBLE_COUNT) + column];
+            class_deltas[class_delta_count][column] = class_table[(row * NIBBLE_COUNT) + column] ^ next;
+            is_empty = is_empty && (class_deltas[class_delta_count][column] == 0);
+        }
+        if (is_empty == false)
+        {
+            class_delta_biases[class_delta_count] = (uint8_t)(0x70 - ((row % (NIBBLE_COUNT / 2)) * NIBBLE_COUNT));
+            class_delta_count++;
+        }
+    }
+
+    decoder_classify_function_t function = decoder_classify_scalar;
+#if defined(CPU_X86)
+    if (cpu_has_avx2() == true)
+    {
+        function = decoder_classify_avx2;
+        classify_implementation = "avx2";
+    }
+    else if (cpu_has_ssse3() == true)
+    {
+        function = decoder_classify_ssse3;
+        classify_implementation = "ssse3";
+    }
+#endif
+    classify_function = function;
+}
+
+void decoder_classify(const uint8_t* const bytes, const uint32_t count, uint8_t* const classes)
+{
+    decoder_classify_init();
+    classify_function(bytes, count, classes);
+}
+
+const char* decoder_classify_get_implementation(void)
+{
+    decoder_classify_init();
+    return classify_implementation;
+}
+
+void decoder_classifier_init(decoder_classifier_t* const classifier, const uint8_t* const inst_stream, const uint32_t inst_stream_len)
+{
+    decoder_classify_init();
+
+    classifier->inst_stream = inst_stream;
+    classifier->inst_stream_len = inst_stream_len;
+    classifier->block_start = 0;
+    classifier->block_end = 0;
+}
+
+uint32_t decoder_classifier_get_length(decoder_classifier_t* const classifier, const uint32_t inst_stream_index)
+{
+    const uint32_t inst_stream_len = classifier->inst_stream_len;
+    if (inst_stream_index >= inst_stream_len)
+    {
+        return 0;
+    }
+
+    if (inst_stream_index >= classifier->block_end)
+    {
+        uint32_t block_len = inst_stream_len - inst_stream_index;
+        if (block_len > DECODER_CLASSIFY_BLOCK_SIZE)
+        {
+            block_len = DECODER_CLASSIFY_BLOCK_SIZE;
+        }
+        classify_function(classifier->inst_stream + inst_stream_index, block_len, classifier->classes);
+        classifier->block_start = inst_stream_index;
+        classifier->block_end = inst_stream_index + block_len;
+    }
+
+    const uint8_t class = classifier->classes[inst_stream_index - classifier->block_start];
+    if ((class & (DECODER_CLASS_GROUP | DECODER_CLASS_PREFIX | DECODER_CLASS_UNKNOWN)) != 0)
+    {
+        return decoder_decode_length(classifier->inst_stream, inst_stream_len, inst_stream_index);
+    }
+
+    uint32_t length = class & DECODER_CLASS_LENGTH_MASK;
+    if ((class & DECODER_CLASS_MODRM) != 0)
+    {
+        if ((inst_stream_index + 1) >= inst_stream_len)
+        {
+            return 0;
+        }
+        length += displacement_sizes[classifier->inst_stream[inst_stream_index + 1]];
+    }
+
+    return ((inst_stream_len - inst_stream_index) >= length) ? length : 0;
+}
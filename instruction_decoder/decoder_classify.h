@@ -0,0 +1,88 @@
+/*
+Copyright (c) 2023 Daniel Fedai Larsen
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef DECODER_CLASSIFY_H
+#define DECODER_CLASSIFY_H
+
+#include <stdint.h>
+
+/* Bytes classified at a time by a classifier, small enough to stay in the L1 cache */
+#define DECODER_CLASSIFY_BLOCK_SIZE 4096U
+
+/**
+ * Finds instruction lengths with the classes of a block of the stream, which are computed ahead of the scan 16 or 32
+ * bytes at a time. Offsets must be asked for in increasing order.
+*/
+typedef struct
+{
+    const uint8_t* inst_stream;
+    uint32_t inst_stream_len;
+    uint32_t block_start;   /* Offset of 'classes[0]' */
+    uint32_t block_end;     /* Offset after the last classified byte */
+    uint8_t classes[DECODER_CLASSIFY_BLOCK_SIZE];
+} decoder_classifier_t;
+
+/**
+ * @brief Build the classification tables and pick the code path for this CPU
+ *
+ * Called by the other functions on first use. Call it before classifying from several threads, or they race to build
+ * the tables.
+*/
+void decoder_classify_init(void);
+
+/**
+ * @brief Classify every byte of a buffer as if an instruction started there
+ *
+ * Uses a shuffle per row of 16 classes with AVX2 or SSSE3 when the CPU has them, and a table lookup per byte otherwise.
+ *
+ * @param bytes Bytes to classify
+ * @param count Number of bytes
+ * @param classes Receives 'count' classes, see 'decoder_get_opcode_class'
+*/
+void decoder_classify(const uint8_t* const bytes, const uint32_t count, uint8_t* const classes);
+
+/**
+ * @brief Get the name of the classification code path picked for this CPU, "avx2", "ssse3" or "scalar"
+*/
+const char* decoder_classify_get_implementation(void);
+
+/**
+ * @brief Start scanning a stream
+ *
+ * @param classifier Classifier to initialize
+ * @param inst_stream Stream of bytes with encoded instructions
+ * @param inst_stream_len Length of 'inst_stream' in bytes
+*/
+void decoder_classifier_init(decoder_classifier_t* const classifier, const uint8_t* const inst_stream, const uint32_t inst_stream_len);
+
+/**
+ * @brief Get the length of an instruction, like 'decoder_decode_length'
+ *
+ * @param classifier Classifier of the stream
+ * @param inst_stream_index Offset of the instruction, not lower than in the previous call
+ * @return Length of the instruction in bytes, 0 if the opcode is unknown or the instruction runs past the end of the
+ *         stream
+*/
+uint32_t decoder_classifier_get_length(decoder_classifier_t* const classifier, const uint32_t inst_stream_index);
+
+#endif
@@ -0,0 +1,153 @@
+/*
+Copyright (c) 2023 Daniel Fedai Larsen
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "decoder_ctx.h"
+
+#include "decoder.h"
+#include "decoder_cache.h"
+#include "decoder_labels.h"
+#include "decoder_stream.h"
+
+#include <stdlib.h>
+
+struct decoder_ctx
+{
+    decoder_config_t config;
+    decoder_sink_t sink;
+    output_buffer_t buffer;     /* Text on its way to the sink, unused without a writer */
+    decoder_stream_t stream;
+    decoder_cache_t cache;      /* Only allocated when configured */
+    decoder_labels_t labels;    /* Only allocated while a stream with labels is being decoded */
+#if defined(DECODER_STATS)
+    decoder_stats_t stats;
+#endif
+};
+
+void decoder_config_init(decoder_config_t* const config)
+{
+    config->buffer_capacity = 0;
+    config->cache_capacity = 0;
+    config->labels = false;
+    config->stats = false;
+}
+
+decoder_ctx_t* decoder_ctx_create(const decoder_config_t* const config, const decoder_sink_t* const sink)
+{
+    decoder_init();
+
+    decoder_ctx_t* const ctx = malloc(sizeof(decoder_ctx_t));
+    if (config != NULL)
+    {
+        ctx->config = *config;
+    }
+    else /* Defaults */
+    {
+        decoder_config_init(&ctx->config);
+    }
+    ctx->sink = *sink;
+
+    if (ctx->sink.write != NULL)
+    {
+        output_buffer_init_with_writer(&ctx->buffer, ctx->config.buffer_capacity, ctx->sink.write, ctx->sink.context);
+    }
+    if (ctx->config.cache_capacity > 0)
+    {
+        decoder_cache_init(&ctx->cache, ctx->config.cache_capacity);
+    }
+#if defined(DECODER_STATS)
+    decoder_stats_init(&ctx->stats);
+#endif
+
+    return ctx;
+}
+
+void decoder_ctx_destroy(decoder_ctx_t* const ctx)
+{
+    if (ctx->sink.write != NULL)
+    {
+        output_buffer_free(&ctx->buffer);
+    }
+    if (ctx->config.cache_capacity > 0)
+    {
+        decoder_cache_free(&ctx->cache);
+    }
+    free(ctx);
+}
+
+void decoder_ctx_begin(decoder_ctx_t* const ctx)
+{
+    output_buffer_t* const buffer = (ctx->sink.write != NULL) ? &ctx->buffer : NULL;
+    decoder_stream_init(&ctx->stream, buffer);
+    ctx->stream.record = ctx->sink.record;
+    ctx->stream.record_context = ctx->sink.context;
+    if (ctx->config.cache_capacity > 0)
+    {
+        ctx->stream.cache = &ctx->cache;
+    }
+    if ((ctx->config.labels == true) && (buffer != NULL))
+    {
+        decoder_labels_init(&ctx->labels, buffer);
+        ctx->stream.labels = &ctx->labels;
+    }
+#if defined(DECODER_STATS)
+    if (ctx->config.stats == true)
+    {
+        ctx->stream.stats = &ctx->stats;
+    }
+#endif
+}
+
+bool decoder_ctx_feed(decoder_ctx_t* const ctx, const uint8_t* const chunk, const uint32_t chunk_len)
+{
+    return decoder_stream_feed(&ctx->stream, chunk, chunk_len);
+}
+
+bool decoder_ctx_finish(decoder_ctx_t* const ctx)
+{
+    const bool success = decoder_stream_finish(&ctx->stream);
+    if (ctx->stream.labels != NULL)
+    {
+        decoder_labels_free(&ctx->labels);
+        ctx->stream.labels = NULL;
+    }
+    if (ctx->sink.write != NULL)
+    {
+        output_buffer_flush(&ctx->buffer);
+    }
+
+    return success;
+}
+
+bool decoder_ctx_decode(decoder_ctx_t* const ctx, const uint8_t* const inst_stream, const uint32_t inst_stream_len)
+{
+    decoder_ctx_begin(ctx);
+    decoder_ctx_feed(ctx, inst_stream, inst_stream_len);
+    return decoder_ctx_finish(ctx);
+}
+
+#if defined(DECODER_STATS)
+const decoder_stats_t* decoder_ctx_get_stats(const decoder_ctx_t* const ctx)
+{
+    return (ctx->config.stats == true) ? &ctx->stats : NULL;
+}
+#endif
@@ -0,0 +1,118 @@
+/*
+Copyright (c) 2023 Daniel Fedai Larsen
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef DECODER_CTX_H
+#define DECODER_CTX_H
+
+#include "decoder_sink.h"
+#include "decoder_stats.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * How a decoder context decodes and formats.
+*/
+typedef struct
+{
+    uint32_t buffer_capacity;   /* Text collected before it's passed to the sink, 0 for OUTPUT_BUFFER_DEFAULT_CAPACITY */
+    uint32_t cache_capacity;    /* Entries in the cache of decoded instructions, 0 for no cache */
+    bool labels;                /* Write branch targets as labels, the text is held until the end of the stream */
+    bool stats;                 /* Collect decode statistics, only available when built with DECODER_STATS */
+} decoder_config_t;
+
+/**
+ * Everything one decoder needs, opaque so it can change without breaking embedders. Contexts share nothing but the
+ * decoder's read-only tables, so each thread can decode with its own context without any locking.
+*/
+typedef struct decoder_ctx decoder_ctx_t;
+
+/**
+ * @brief Get the default configuration, plain text without cache, labels or statistics
+ *
+ * @param config Configuration to fill in
+*/
+void decoder_config_init(decoder_config_t* const config);
+
+/**
+ * @brief Create a decoder context
+ *
+ * Builds the decoder's tables on first use. Create the first context before creating others on several threads at
+ * once, or call 'decoder_init' up front.
+ *
+ * @param config Configuration, NULL for the default one
+ * @param sink Where the output goes, copied into the context
+ * @return New context, free it with 'decoder_ctx_destroy'
+*/
+decoder_ctx_t* decoder_ctx_create(const decoder_config_t* const config, const decoder_sink_t* const sink);
+
+/**
+ * @brief Free a context and everything it holds
+*/
+void decoder_ctx_destroy(decoder_ctx_t* const ctx);
+
+/**
+ * @brief Start decoding a new stream, writes the assembly header
+ *
+ * @param ctx Context to decode with
+*/
+void decoder_ctx_begin(decoder_ctx_t* const ctx);
+
+/**
+ * @brief Decode the next chunk of the stream, chunks can end in the middle of an instruction
+ *
+ * @param ctx Context the stream was begun with
+ * @param chunk Next bytes of the stream
+ * @param chunk_len Length of 'chunk' in bytes
+ * @return false if an unknown opcode was found, in this or an earlier chunk
+*/
+bool decoder_ctx_feed(decoder_ctx_t* const ctx, const uint8_t* const chunk, const uint32_t chunk_len);
+
+/**
+ * @brief Mark the end of the stream and pass all remaining text to the sink
+ *
+ * @param ctx Context the stream was begun with
+ * @return false if decoding failed or the stream ended in the middle of an instruction
+*/
+bool decoder_ctx_finish(decoder_ctx_t* const ctx);
+
+/**
+ * @brief Decode a whole stream, the same as begin, feed and finish
+ *
+ * @param ctx Context to decode with
+ * @param inst_stream Stream of bytes with encoded instructions
+ * @param inst_stream_len Length of 'inst_stream' in bytes
+ * @return false if decoding failed
+*/
+bool decoder_ctx_decode(decoder_ctx_t* const ctx, const uint8_t* const inst_stream, const uint32_t inst_stream_len);
+
+#if defined(DECODER_STATS)
+/**
+ * @brief Get the statistics of every stream decoded with a context so far
+ *
+ * @return Statistics, or NULL if the context wasn't configured to collect them
+*/
+const decoder_stats_t* decoder_ctx_get_stats(const decoder_ctx_t* const ctx);
+#endif
+
+#endif
@@ -0,0 +1,325 @@
+/*
+Copyright (c) 2023 Daniel Fedai Larsen
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "decoder_flow.h"
+
+#include "decoder.h"
+#include "decoder_format.h"
+
+#include <stdlib.h>
+
+#define DECODER_FLOW_MIN_CAPACITY 64U
+
+typedef enum
+{
+    FLOW_NEXT = 0,  /* Continues with the next instruction */
+    FLOW_BRANCH,    /* Goes to a target or the next instruction */
+    FLOW_JUMP,      /* Goes to a target */
+    FLOW_CALL,      /* Goes to a target and comes back to the next instruction */
+    FLOW_STOP,      /* Goes somewhere the decoder can't tell, or returns */
+} flow_kind_t;
+
+static bool flow_test(const uint8_t* const bitmap, const uint32_t offset)
+{
+    return (bitmap[offset >> 3] & (1U << (offset & 0x7))) != 0;
+}
+
+static void flow_set(uint8_t* const bitmap, const uint32_t offset)
+{
+    bitmap[offset >> 3] |= (uint8_t)(1U << (offset & 0x7));
+}
+
+static void flow_clear(uint8_t* const bitmap, const uint32_t offset)
+{
+    bitmap[offset >> 3] &= (uint8_t)~(1U << (offset & 0x7));
+}
+
+static flow_kind_t flow_get_kind(const instruction_t* const inst)
+{
+    const bool is_relative = inst->operands[0].kind == OPERAND_RELATIVE;
+    if ((inst->operation >= OPERATION_JE) && (inst->operation <= OPERATION_JCXZ))
+    {
+        return FLOW_BRANCH;
+    }
+
+    switch (inst->operation)
+    {
+        case OPERATION_JMP:
+        {
+            return (is_relative == true) ? FLOW_JUMP : FLOW_STOP;
+        }
+        case OPERATION_CALL:
+        {
+            return (is_relative == true) ? FLOW_CALL : FLOW_NEXT;
+        }
+        case OPERATION_RET:
+        case OPERATION_RETF:
+        case OPERATION_IRET:
+        {
+            return FLOW_STOP;
+        }
+        default:
+        {
+            return FLOW_NEXT;
+        }
+    }
+}
+
+/**
+ * Offset a relative operand points to. Returns false if it's outside the stream.
+*/
+static bool flow_get_target(const decoder_flow_t* const flow, const uint32_t offset, const instruction_t* const inst, uint32_t* const target)
+{
+    const int64_t target_offset = (int64_t)offset + inst->length + (int16_t)inst->immediate;
+    if ((target_offset < 0) || (target_offset >= flow->inst_stream_len))
+    {
+        return false;
+    }
+
+    *target = (uint32_t)target_offset;
+    return true;
+}
+
+static decoder_flow_block_t* flow_add_block(decoder_flow_t* const flow, const uint32_t start)
+{
+    if (flow->block_count == flow->block_capacity)
+    {
+        flow->block_capacity *= 2;
+        flow->blocks = realloc(flow->blocks, flow->block_capacity * sizeof(decoder_flow_block_t));
+    }
+
+    decoder_flow_block_t* const block = &flow->blocks[flow->block_count];
+    block->start = start;
+    block->end = start;
+    block->successor_count = 0;
+    flow->block_count++;
+    return block;
+}
+
+/**
+ * Decode from every entry point and every target found on the way, until reaching code that's already been decoded.
+*/
+static void flow_traverse(decoder_flow_t* const flow, const uint32_t* const entries, const uint32_t entry_count)
+{
+    uint32_t worklist_capacity = entry_count + DECODER_FLOW_MIN_CAPACITY;
+    uint32_t* worklist = malloc(worklist_capacity * sizeof(uint32_t));
+    uint32_t worklist_count = 0;
+    for (uint32_t i = 0; i < entry_count; i++)
+    {
+        if (entries[i] < flow->inst_stream_len)
+        {
+            flow_set(flow->block_starts, entries[i]);
+            worklist[worklist_count++] = entries[i];
+        }
+    }
+
+    instruction_t inst;
+    while (worklist_count > 0)
+    {
+        uint32_t offset = worklist[--worklist_count];
+        while ((offset < flow->inst_stream_len) && (flow_test(flow->inst_starts, offset) == false))
+        {
+            if (decoder_decode_one(flow->inst_stream, flow->inst_stream_len, offset, &inst) == false)
+            {
+                break;
+            }
+            flow_set(flow->inst_starts, offset);
+
+            const flow_kind_t kind = flow_get_kind(&inst);
+            uint32_t target;
+            if ((kind != FLOW_NEXT) && (kind != FLOW_STOP) && (flow_get_target(flow, offset, &inst, &target) == true))
+            {
+                flow_set(flow->labels, target);
+                flow_set(flow->block_starts, target);
+                if (flow_test(flow->inst_starts, target) == false)
+                {
+                    if (worklist_count == worklist_capacity)
+                    {
+                        worklist_capacity *= 2;
+                        worklist = realloc(worklist, worklist_capacity * sizeof(uint32_t));
+                    }
+                    worklist[worklist_count++] = target;
+                }
+            }
+
+            offset += inst.length;
+            if ((kind == FLOW_JUMP) || (kind == FLOW_STOP))
+            {
+                break;
+            }
+            if (kind == FLOW_BRANCH)
+            {
+                flow_set(flow->block_starts, offset);
+            }
+        }
+    }
+
+    free(worklist);
+}
+
+/**
+ * Walk the decoded instructions in order of offset, drop the ones hidden inside an earlier instruction and split the
+ * rest into basic blocks.
+*/
+static void flow_build_blocks(decoder_flow_t* const flow)
+{
+    decoder_flow_block_t* block = NULL;
+    bool falls_through = false;
+    instruction_t inst;
+    uint32_t offset = 0;
+    while (offset < flow->inst_stream_len)
+    {
+        if (flow_test(flow->inst_starts, offset) == false)
+        {
+            offset++;
+            continue;
+        }
+        decoder_decode_one(flow->inst_stream, flow->inst_stream_len, offset, &inst);
+        flow->inst_count++;
+
+        /* Instructions starting inside this one can't be listed */
+        for (uint32_t i = offset + 1; i < (offset + inst.length); i++)
+        {
+            flow_clear(flow->inst_starts, i);
+            flow_clear(flow->labels, i);
+            flow_clear(flow->block_starts, i);
+        }
+
+        /* A new block starts at a target, or after a gap or an instruction that ended the previous block */
+        const bool is_contiguous = (block != NULL) && (block->end == offset);
+        if ((is_contiguous == false) || (falls_through == false) || (flow_test(flow->block_starts, offset) == true))
+        {
+            if ((block != NULL) && (falls_through == true) && (is_contiguous == true))
+            {
+                block->successors[block->successor_count++] = offset;
+            }
+            block = flow_add_block(flow, offset);
+        }
+        block->end = offset + inst.length;
+
+        const flow_kind_t kind = flow_get_kind(&inst);
+        uint32_t target;
+        falls_through = (kind == FLOW_NEXT) || (kind == FLOW_CALL);
+        if ((kind == FLOW_BRANCH) || (kind == FLOW_JUMP))
+        {
+            if (flow_get_target(flow, offset, &inst, &target) == true)
+            {
+                block->successors[block->successor_count++] = target;
+            }
+            if (kind == FLOW_BRANCH)
+            {
+                block->successors[block->successor_count++] = block->end;
+            }
+        }
+        offset += inst.length;
+    }
+
+    /* Targets that didn't decode are listed as data, so jumps to them can't use a label */
+    const uint32_t bitmap_size = (flow->inst_stream_len + 7) / 8;
+    for (uint32_t i = 0; i < bitmap_size; i++)
+    {
+        flow->labels[i] &= flow->inst_starts[i];
+    }
+}
+
+void decoder_flow_analyze(decoder_flow_t* const flow, const uint8_t* const inst_stream, const uint32_t inst_stream_len, const uint32_t* const entries, const uint32_t entry_count)
+{
+    decoder_init();
+
+    const uint32_t bitmap_size = (inst_stream_len + 7) / 8;
+    flow->inst_stream = inst_stream;
+    flow->inst_stream_len = inst_stream_len;
+    flow->inst_starts = calloc(bitmap_size + 1, 1);
+    flow->labels = calloc(bitmap_size + 1, 1);
+    flow->block_starts = calloc(bitmap_size + 1, 1);
+    flow->block_capacity = DECODER_FLOW_MIN_CAPACITY;
+    flow->blocks = malloc(flow->block_capacity * sizeof(decoder_flow_block_t));
+    flow->block_count = 0;
+    flow->inst_count = 0;
+
+    flow_traverse(flow, entries, entry_count);
+    flow_build_blocks(flow);
+}
+
+void decoder_flow_format(const decoder_flow_t* const flow, output_buffer_t* const buffer)
+{
+    output_buffer_append_string(buffer, "bits 16\n");
+
+    uint32_t block_index = 0;
+    instruction_t inst;
+    uint32_t offset = 0;
+    while (offset < flow->inst_stream_len)
+    {
+        /* Bytes up to the next instruction are data */
+        if (flow_test(flow->inst_starts, offset) == false)
+        {
+            const uint32_t data_start = offset;
+            while ((offset < flow->inst_stream_len) && (flow_test(flow->inst_starts, offset) == false))
+            {
+                offset++;
+            }
+            output_buffer_append_char(buffer, '\n');
+            decoder_format_data(flow->inst_stream + data_start, offset - data_start, buffer);
+            continue;
+        }
+
+        if ((block_index < flow->block_count) && (flow->blocks[block_index].start == offset))
+        {
+            const decoder_flow_block_t* const block = &flow->blocks[block_index];
+            output_buffer_append_char(buffer, '\n');
+            decoder_format_block_comment(block->start, block->end, block->successors, block->successor_count, buffer);
+            block_index++;
+        }
+        if (flow_test(flow->labels, offset) == true)
+        {
+            decoder_format_label(offset, buffer);
+        }
+
+        decoder_decode_one(flow->inst_stream, flow->inst_stream_len, offset, &inst);
+        uint32_t target;
+        if ((inst.operands[0].kind == OPERAND_RELATIVE) && (flow_get_target(flow, offset, &inst, &target) == true) &&
+            (flow_test(flow->labels, target) == true))
+        {
+            decoder_format_instruction_with_label(&inst, target, buffer);
+        }
+        else /* No label to refer to */
+        {
+            decoder_format_instruction(&inst, buffer);
+        }
+        offset += inst.length;
+    }
+}
+
+void decoder_flow_free(decoder_flow_t* const flow)
+{
+    free(flow->inst_starts);
+    free(flow->labels);
+    free(flow->block_starts);
+    free(flow->blocks);
+    flow->inst_starts = NULL;
+    flow->labels = NULL;
+    flow->block_starts = NULL;
+    flow->blocks = NULL;
+    flow->block_count = 0;
+    flow->block_capacity = 0;
+}
@@ -0,0 +1,95 @@
+/*
+Copyright (c) 2023 Daniel Fedai Larsen
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef DECODER_FLOW_H
+#define DECODER_FLOW_H
+
+#include "output_buffer.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* A conditional branch has a target and a fall-through */
+#define DECODER_FLOW_MAX_SUCCESSORS 2U
+
+/**
+ * Straight-line run of instructions that's only entered at the top and only left at the bottom. Calls don't end a block,
+ * the called code starts a block of its own.
+*/
+typedef struct
+{
+    uint32_t start;                                     /* Offset of the first instruction */
+    uint32_t end;                                       /* Offset after the last instruction */
+    uint32_t successors[DECODER_FLOW_MAX_SUCCESSORS];   /* Blocks control passes to, jump target first */
+    uint32_t successor_count;
+} decoder_flow_block_t;
+
+/**
+ * Code found by following control flow from the entry points, instead of decoding the stream from start to end. Bytes
+ * that are never reached are data. Every byte is decoded as the start of an instruction at most once, so the analysis
+ * is linear in the size of the stream.
+*/
+typedef struct
+{
+    const uint8_t* inst_stream;
+    uint32_t inst_stream_len;
+    uint8_t* inst_starts;   /* One bit per byte, set where a listed instruction starts */
+    uint8_t* labels;        /* One bit per byte, set where a listed instruction is the target of a jump or call */
+    uint8_t* block_starts;  /* One bit per byte, set where a basic block starts */
+    decoder_flow_block_t* blocks;   /* In increasing order of offset */
+    uint32_t block_count;
+    uint32_t block_capacity;
+    uint32_t inst_count;
+} decoder_flow_t;
+
+/**
+ * @brief Find the code reachable from a set of entry points, and its basic blocks
+ *
+ * Instructions that overlap an instruction earlier in the stream are left out of the listing, jumps into them keep
+ * their relative target.
+ *
+ * @param flow Result, free it with 'decoder_flow_free'
+ * @param inst_stream Stream of bytes with encoded instructions
+ * @param inst_stream_len Length of 'inst_stream' in bytes
+ * @param entries Offsets where execution can start
+ * @param entry_count Number of entry points
+*/
+void decoder_flow_analyze(decoder_flow_t* const flow, const uint8_t* const inst_stream, const uint32_t inst_stream_len, const uint32_t* const entries, const uint32_t entry_count);
+
+/**
+ * @brief Write the analyzed stream as assembly NASM can assemble back into it
+ *
+ * Jump targets get generated labels, each basic block starts with a comment naming its successors and bytes that aren't
+ * code are written as 'db' lines.
+ *
+ * @param flow Analyzed stream
+ * @param buffer Buffer to append the listing to
+*/
+void decoder_flow_format(const decoder_flow_t* const flow, output_buffer_t* const buffer);
+
+/**
+ * @brief Free the bitmaps and blocks
+*/
+void decoder_flow_free(decoder_flow_t* const flow);
+
+#endif
@@ -0,0 +1,566 @@
+/*
+Copyright (c) 2023 Daniel Fedai Larsen
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "decoder_format.h"
+
+#include <stdbool.h>
+#include <string.h>
+
+/* Size of a fragment's text, every fragment is copied whole and the cursor moves on by its length */
+#define FORMAT_FRAGMENT_SIZE 16U
+
+#define FRAGMENT(text) { text, sizeof(text) - 1 }
+
+/**
+ * Preassembled piece of a line. Copying the whole fixed-size array is cheaper than finding the length of a string and
+ * copying exactly that many bytes.
+*/
+typedef struct
+{
+    char text[FORMAT_FRAGMENT_SIZE];
+    uint8_t len;
+} format_fragment_t;
+
+static const format_fragment_t operation_names[OPERATION_COUNT] = {
+    FRAGMENT(""),
+    FRAGMENT("mov"),
+    FRAGMENT("push"),
+    FRAGMENT("pop"),
+    FRAGMENT("xchg"),
+    FRAGMENT("in"),
+    FRAGMENT("out"),
+    FRAGMENT("xlat"),
+    FRAGMENT("lea"),
+    FRAGMENT("lds"),
+    FRAGMENT("les"),
+    FRAGMENT("lahf"),
+    FRAGMENT("sahf"),
+    FRAGMENT("pushf"),
+    FRAGMENT("popf"),
+    FRAGMENT("add"),
+    FRAGMENT("adc"),
+    FRAGMENT("inc"),
+    FRAGMENT("aaa"),
+    FRAGMENT("daa"),
+    FRAGMENT("sub"),
+    FRAGMENT("sbb"),
+    FRAGMENT("dec"),
+    FRAGMENT("neg"),
+    FRAGMENT("cmp"),
+    FRAGMENT("aas"),
+    FRAGMENT("das"),
+    FRAGMENT("mul"),
+    FRAGMENT("imul"),
+    FRAGMENT("aam"),
+    FRAGMENT("div"),
+    FRAGMENT("idiv"),
+    FRAGMENT("aad"),
+    FRAGMENT("cbw"),
+    FRAGMENT("cwd"),
+    FRAGMENT("not"),
+    FRAGMENT("shl"),
+    FRAGMENT("shr"),
+    FRAGMENT("sar"),
+    FRAGMENT("rol"),
+    FRAGMENT("ror"),
+    FRAGMENT("rcl"),
+    FRAGMENT("rcr"),
+    FRAGMENT("and"),
+    FRAGMENT("test"),
+    FRAGMENT("or"),
+    FRAGMENT("xor"),
+    FRAGMENT("movs"),
+    FRAGMENT("cmps"),
+    FRAGMENT("scas"),
+    FRAGMENT("lods"),
+    FRAGMENT("stos"),
+    FRAGMENT("call"),
+    FRAGMENT("jmp"),
+    FRAGMENT("ret"),
+    FRAGMENT("retf"),
+    FRAGMENT("je"),
+    FRAGMENT("jl"),
+    FRAGMENT("jle"),
+    FRAGMENT("jb"),
+    FRAGMENT("jbe"),
+    FRAGMENT("jp"),
+    FRAGMENT("jo"),
+    FRAGMENT("js"),
+    FRAGMENT("jne"),
+    FRAGMENT("jnl"),
+    FRAGMENT("jg"),
+    FRAGMENT("jnb"),
+    FRAGMENT("ja"),
+    FRAGMENT("jnp"),
+    FRAGMENT("jno"),
+    FRAGMENT("jns"),
+    FRAGMENT("loop"),
+    FRAGMENT("loopz"),
+    FRAGMENT("loopnz"),
+    FRAGMENT("jcxz"),
+    FRAGMENT("int"),
+    FRAGMENT("int3"),
+    FRAGMENT("into"),
+    FRAGMENT("iret"),
+    FRAGMENT("clc"),
+    FRAGMENT("cmc"),
+    FRAGMENT("stc"),
+    FRAGMENT("cld"),
+    FRAGMENT("std"),
+    FRAGMENT("cli"),
+    FRAGMENT("sti"),
+    FRAGMENT("hlt"),
+    FRAGMENT("wait"),
+    FRAGMENT("esc"),
+    FRAGMENT("lock"),
+    FRAGMENT("rep"),
+    FRAGMENT("")  /* Segment override, written on the operand */
+};
+
+static const format_fragment_t register_names[REGISTER_COUNT] = {
+    /* W=0 */
+    FRAGMENT("al"),
+    FRAGMENT("cl"),
+    FRAGMENT("dl"),
+    FRAGMENT("bl"),
+    FRAGMENT("ah"),
+    FRAGMENT("ch"),
+    FRAGMENT("dh"),
+    FRAGMENT("bh"),
+    /* W=1 */
+    FRAGMENT("ax"),
+    FRAGMENT("cx"),
+    FRAGMENT("dx"),
+    FRAGMENT("bx"),
+    FRAGMENT("sp"),
+    FRAGMENT("bp"),
+    FRAGMENT("si"),
+    FRAGMENT("di"),
+    /* Segment registers */
+    FRAGMENT("es"),
+    FRAGMENT("cs"),
+    FRAGMENT("ss"),
+    FRAGMENT("ds")
+};
+
+static const format_fragment_t effective_address_names[EFFECTIVE_ADDRESS_COUNT] = {
+    FRAGMENT("bx + si"),
+    FRAGMENT("bx + di"),
+    FRAGMENT("bp + si"),
+    FRAGMENT("bp + di"),
+    FRAGMENT("si"),
+    FRAGMENT("di"),
+    FRAGMENT("bp"),
+    FRAGMENT("bx"),
+    FRAGMENT("") /* Direct address */
+};
+
+typedef enum
+{
+    MEMORY_SIZE_NONE = 0,
+    MEMORY_SIZE_BYTE,
+    MEMORY_SIZE_WORD,
+    MEMORY_SIZE_FAR,
+    MEMORY_SIZE_COUNT
+} memory_size_t;
+
+/* Start of a memory operand up to the bracket, by size keyword and by segment override (none, then ES to DS) */
+static const format_fragment_t memory_prefixes[MEMORY_SIZE_COUNT][5] = {
+    { FRAGMENT("["), FRAGMENT("es:["), FRAGMENT("cs:["), FRAGMENT("ss:["), FRAGMENT("ds:[") },
+    { FRAGMENT("byte ["), FRAGMENT("byte es:["), FRAGMENT("byte cs:["), FRAGMENT("byte ss:["), FRAGMENT("byte ds:[") },
+    { FRAGMENT("word ["), FRAGMENT("word es:["), FRAGMENT("word cs:["), FRAGMENT("word ss:["), FRAGMENT("word ds:[") },
+    { FRAGMENT("far ["), FRAGMENT("far es:["), FRAGMENT("far cs:["), FRAGMENT("far ss:["), FRAGMENT("far ds:[") },
+};
+
+/* Prefixes of the instruction, indexed by LOCK and then REP (1) or REPNE (2) */
+static const format_fragment_t instruction_prefixes[2][3] = {
+    { FRAGMENT(""), FRAGMENT("rep "), FRAGMENT("repne ") },
+    { FRAGMENT("lock "), FRAGMENT("lock rep "), FRAGMENT("lock repne ") },
+};
+
+/* Two decimal digits of every value below 100 */
+static const char digit_pairs[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+static const char hex_digits[] = "0123456789ABCDEF";
+
+static char* format_fragment(char* const cursor, const format_fragment_t* const fragment)
+{
+    memcpy(cursor, fragment->text, FORMAT_FRAGMENT_SIZE);
+    return cursor + fragment->len;
+}
+
+/**
+ * Write a value of up to five digits, two digits at a time from the table.
+*/
+static char* format_uint16(char* cursor, uint32_t value)
+{
+    if (value < 10)
+    {
+        *cursor = (char)('0' + value);
+        return cursor + 1;
+    }
+    if (value < 100)
+    {
+        memcpy(cursor, &digit_pairs[value * 2], 2);
+        return cursor + 2;
+    }
+    if (value < 1000)
+    {
+        *cursor = (char)('0' + (value / 100));
+        memcpy(cursor + 1, &digit_pairs[(value % 100) * 2], 2);
+        return cursor + 3;
+    }
+    if (value >= 10000)
+    {
+        *cursor++ = (char)('0' + (value / 10000));
+        value %= 10000;
+    }
+    memcpy(cursor, &digit_pairs[(value / 100) * 2], 2);
+    memcpy(cursor + 2, &digit_pairs[(value % 100) * 2], 2);
+    return cursor + 4;
+}
+
+static char* format_int16(char* cursor, const int32_t value)
+{
+    if (value < 0)
+    {
+        *cursor++ = '-';
+        return format_uint16(cursor, (uint32_t)-value);
+    }
+
+    return format_uint16(cursor, (uint32_t)value);
+}
+
+static char* format_memory_operand(char* cursor, const instruction_t* const inst, const operand_t* const operand)
+{
+    memory_size_t size = MEMORY_SIZE_NONE;
+    if (inst->flags & INSTRUCTION_FLAG_EXPLICIT_SIZE)
+    {
+        size = (inst->w == 1) ? MEMORY_SIZE_WORD : MEMORY_SIZE_BYTE;
+    }
+    else if (inst->flags & INSTRUCTION_FLAG_FAR)
+    {
+        size = MEMORY_SIZE_FAR;
+    }
+    const uint32_t segment = (inst->flags & INSTRUCTION_FLAG_SEGMENT_OVERRIDE) ? (inst->segment - REGISTER_ES + 1U) : 0U;
+    cursor = format_fragment(cursor, &memory_prefixes[size][segment]);
+
+    /* Direct address */
+    if (operand->value == EFFECTIVE_ADDRESS_DIRECT)
+    {
+        cursor = format_uint16(cursor, inst->displacement);
+        *cursor++ = ']';
+        return cursor;
+    }
+
+    cursor = format_fragment(cursor, &effective_address_names[operand->value]);
+    if (inst->flags & INSTRUCTION_FLAG_HAS_DISPLACEMENT)
+    {
+        const int32_t displacement = (int16_t)inst->displacement;
+        if (displacement >= 0)
+        {
+            memcpy(cursor, " + ", 3);
+            cursor = format_uint16(cursor + 3, (uint32_t)displacement);
+        }
+        else /* displacement < 0 */
+        {
+            memcpy(cursor, " - ", 3);
+            cursor = format_uint16(cursor + 3, (uint32_t)-displacement);
+        }
+    }
+    *cursor++ = ']';
+    return cursor;
+}
+
+/**
+ * Write an offset in hex, at least four digits and more for large images.
+*/
+static char* format_hex_offset(char* cursor, const uint32_t offset)
+{
+    uint32_t digit_count = 4;
+    while ((digit_count < 8) && ((offset >> (digit_count * 4)) != 0))
+    {
+        digit_count++;
+    }
+    for (uint32_t i = digit_count; i > 0; i--)
+    {
+        *cursor++ = hex_digits[(offset >> ((i - 1) * 4)) & 0xF];
+    }
+
+    return cursor;
+}
+
+/**
+ * Write the generated name of the label at 'offset', e.g. "label_01A0".
+*/
+static char* format_label_name(char* cursor, const uint32_t offset)
+{
+    memcpy(cursor, "label_", 6);
+    return format_hex_offset(cursor + 6, offset);
+}
+
+static char* format_hex_byte(char* cursor, const uint8_t value)
+{
+    cursor[0] = '0';
+    cursor[1] = 'x';
+    cursor[2] = hex_digits[value >> 4];
+    cursor[3] = hex_digits[value & 0xF];
+    return cursor + 4;
+}
+
+static char* format_operand(char* cursor, const instruction_t* const inst, const operand_t* const operand, const uint32_t* const target)
+{
+    switch (operand->kind)
+    {
+        case OPERAND_REGISTER:
+        {
+            cursor = format_fragment(cursor, &register_names[operand->value]);
+            break;
+        }
+        case OPERAND_MEMORY:
+        {
+            cursor = format_memory_operand(cursor, inst, operand);
+            break;
+        }
+        case OPERAND_IMMEDIATE:
+        {
+            if (inst->flags & INSTRUCTION_FLAG_SIGN_EXTENDED)
+            {
+                cursor = format_int16(cursor, (int16_t)inst->immediate);
+            }
+            else /* Not sign-extended */
+            {
+                cursor = format_uint16(cursor, inst->immediate);
+            }
+            break;
+        }
+        case OPERAND_RELATIVE:
+        {
+            if (target != NULL)
+            {
+                cursor = format_label_name(cursor, *target);
+                break;
+            }
+
+            /* Relative to the start of the instruction, NASM's '$' */
+            const int32_t offset = (int32_t)(int16_t)inst->immediate + inst->length;
+            *cursor++ = '$';
+            if (offset >= 0)
+            {
+                *cursor++ = '+';
+            }
+            cursor = format_int16(cursor, offset);
+            break;
+        }
+        case OPERAND_FAR_POINTER:
+        {
+            cursor = format_uint16(cursor, inst->immediate);
+            *cursor++ = ':';
+            cursor = format_uint16(cursor, inst->displacement);
+            break;
+        }
+        default:
+        {
+            break;
+        }
+    }
+
+    return cursor;
+}
+
+/**
+ * Write an instruction, with the relative operand as the label of 'target' unless it's NULL.
+*/
+static void format_instruction(const instruction_t* const inst, const uint32_t* const target, output_buffer_t* const buffer)
+{
+    char* cursor = output_buffer_reserve(buffer, DECODER_FORMAT_LINE_MAX);
+
+    /* Prefixes */
+    const uint32_t lock = (inst->flags & INSTRUCTION_FLAG_LOCK) ? 1U : 0U;
+    const uint32_t rep = (inst->flags & INSTRUCTION_FLAG_REP) ? 1U : ((inst->flags & INSTRUCTION_FLAG_REPNE) ? 2U : 0U);
+    cursor = format_fragment(cursor, &instruction_prefixes[lock][rep]);
+
+    /* A segment override is written on the memory operand, NASM takes it as a prefix when there's none */
+    const bool has_memory_operand = (inst->operands[0].kind == OPERAND_MEMORY) || (inst->operands[1].kind == OPERAND_MEMORY);
+    if ((inst->flags & INSTRUCTION_FLAG_SEGMENT_OVERRIDE) && (has_memory_operand == false))
+    {
+        cursor = format_fragment(cursor, &register_names[inst->segment]);
+        *cursor++ = ' ';
+    }
+
+    cursor = format_fragment(cursor, &operation_names[inst->operation]);
+    if (inst->flags & INSTRUCTION_FLAG_WIDTH_SUFFIX)
+    {
+        *cursor++ = (inst->w == 1) ? 'w' : 'b';
+    }
+
+    for (uint8_t i = 0; i < INSTRUCTION_OPERAND_COUNT; i++)
+    {
+        const operand_t* const operand = &inst->operands[i];
+        if (operand->kind == OPERAND_NONE)
+        {
+            break;
+        }
+
+        if (i == 0)
+        {
+            *cursor++ = ' ';
+        }
+        else /* i > 0 */
+        {
+            memcpy(cursor, ", ", 2);
+            cursor += 2;
+        }
+        cursor = format_operand(cursor, inst, operand, target);
+    }
+
+    *cursor++ = '\n';
+    output_buffer_commit(buffer, cursor);
+}
+
+void decoder_format_instruction(const instruction_t* const inst, output_buffer_t* const buffer)
+{
+    format_instruction(inst, NULL, buffer);
+}
+
+void decoder_format_instruction_with_label(const instruction_t* const inst, const uint32_t target, output_buffer_t* const buffer)
+{
+    format_instruction(inst, &target, buffer);
+}
+
+void decoder_format_label(const uint32_t offset, output_buffer_t* const buffer)
+{
+    char* cursor = output_buffer_reserve(buffer, DECODER_FORMAT_LINE_MAX);
+    cursor = format_label_name(cursor, offset);
+    cursor[0] = ':';
+    cursor[1] = '\n';
+    output_buffer_commit(buffer, cursor + 2);
+}
+
+void decoder_format_label_equ(const uint32_t offset, const uint32_t distance, output_buffer_t* const buffer)
+{
+    char* cursor = output_buffer_reserve(buffer, DECODER_FORMAT_LINE_MAX);
+    cursor = format_label_name(cursor, offset);
+    memcpy(cursor, " equ $+", 7);
+    cursor = format_uint16(cursor + 7, distance);
+    *cursor++ = '\n';
+    output_buffer_commit(buffer, cursor);
+}
+
+void decoder_format_block_comment(const uint32_t start, const uint32_t end, const uint32_t* const successors, const uint32_t successor_count, output_buffer_t* const buffer)
+{
+    char* cursor = output_buffer_reserve(buffer, DECODER_FORMAT_LINE_MAX);
+    memcpy(cursor, "; block ", 8);
+    cursor = format_hex_offset(cursor + 8, start);
+    *cursor++ = '-';
+    cursor = format_hex_offset(cursor, end);
+    if (successor_count > 0)
+    {
+        memcpy(cursor, " ->", 3);
+        cursor += 3;
+        for (uint32_t i = 0; i < successor_count; i++)
+        {
+            *cursor++ = ' ';
+            cursor = format_hex_offset(cursor, successors[i]);
+        }
+    }
+    *cursor++ = '\n';
+    output_buffer_commit(buffer, cursor);
+}
+
+void decoder_format_data(const uint8_t* const bytes, const uint32_t count, output_buffer_t* const buffer)
+{
+    for (uint32_t line_start = 0; line_start < count; line_start += DECODER_FORMAT_DATA_PER_LINE)
+    {
+        const uint32_t line_end = ((count - line_start) > DECODER_FORMAT_DATA_PER_LINE) ? (line_start + DECODER_FORMAT_DATA_PER_LINE) : count;
+        char* cursor = output_buffer_reserve(buffer, 4 + (DECODER_FORMAT_DATA_PER_LINE * 6));
+        memcpy(cursor, "db ", 3);
+        cursor += 3;
+        for (uint32_t i = line_start; i < line_end; i++)
+        {
+            if (i > line_start)
+            {
+                memcpy(cursor, ", ", 2);
+                cursor += 2;
+            }
+            cursor = format_hex_byte(cursor, bytes[i]);
+        }
+        *cursor++ = '\n';
+        output_buffer_commit(buffer, cursor);
+    }
+}
+
+const char* decoder_format_get_operation_name(const uint8_t operation)
+{
+    return operation_names[operation].text;
+}
+
+const char* decoder_format_get_effective_address_name(const uint8_t effective_address)
+{
+    return effective_address_names[effective_address].text;
+}
+
+void decoder_format_unknown_opcode(const uint8_t opcode, output_buffer_t* const buffer)
+{
+    static const char message[] = "[DECODE] Unknown opcode (0x";
+    char* cursor = output_buffer_reserve(buffer, DECODER_FORMAT_LINE_MAX);
+    memcpy(cursor, message, sizeof(message) - 1);
+    cursor += sizeof(message) - 1;
+    *cursor++ = hex_digits[opcode >> 4];
+    *cursor++ = hex_digits[opcode & 0xF];
+    memcpy(cursor, ")\n", 2);
+    output_buffer_commit(buffer, cursor + 2);
+}
+
+void decoder_format_truncated_instruction(const uint64_t offset, output_buffer_t* const buffer)
+{
+    static const char message[] = "[DECODE] Truncated instruction at offset ";
+    char* cursor = output_buffer_reserve(buffer, DECODER_FORMAT_LINE_MAX);
+    memcpy(cursor, message, sizeof(message) - 1);
+    cursor += sizeof(message) - 1;
+
+    /* Offsets can be longer than 16 bits, produce the digits from the back */
+    char digits[20];
+    uint32_t start = sizeof(digits);
+    uint64_t value = offset;
+    do
+    {
+        digits[--start] = (char)('0' + (value % 10));
+        value /= 10;
+    } while (value != 0);
+    memcpy(cursor, &digits[start], sizeof(digits) - start);
+    cursor += sizeof(digits) - start;
+
+    *cursor++ = '\n';
+    output_buffer_commit(buffer, cursor);
+}
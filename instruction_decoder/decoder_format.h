@@ -0,0 +1,117 @@
+/*
+Copyright (c) 2023 Daniel Fedai Larsen
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef DECODER_FORMAT_H
+#define DECODER_FORMAT_H
+
+#include "instruction.h"
+#include "output_buffer.h"
+
+#include <stdint.h>
+
+/* Room reserved for each line, fragment copies included. A buffer with this much room left is written to in place */
+#define DECODER_FORMAT_LINE_MAX 128U
+/* Bytes per 'db' line written by 'decoder_format_data' */
+#define DECODER_FORMAT_DATA_PER_LINE 16U
+
+/**
+ * @brief Write a decoded instruction as a line of NASM assembly
+ *
+ * @param inst Decoded instruction
+ * @param buffer Buffer to append the formatted instruction to
+*/
+void decoder_format_instruction(const instruction_t* const inst, output_buffer_t* const buffer);
+
+/**
+ * @brief Write a decoded instruction with its relative operand as the generated label of the target
+ *
+ * @param inst Decoded jump, call or loop with an OPERAND_RELATIVE operand
+ * @param target Offset of the target in the stream
+ * @param buffer Buffer to append the formatted instruction to
+*/
+void decoder_format_instruction_with_label(const instruction_t* const inst, const uint32_t target, output_buffer_t* const buffer);
+
+/**
+ * @brief Write the line defining the generated label of an offset, e.g. "label_01A0:"
+ *
+ * @param offset Offset in the stream
+ * @param buffer Buffer to append the label to
+*/
+void decoder_format_label(const uint32_t offset, output_buffer_t* const buffer);
+
+/**
+ * @brief Write a line defining the generated label of an offset relative to the current one, e.g. "label_01A2 equ $+2"
+ *
+ * @param offset Offset in the stream
+ * @param distance Bytes from the current offset to 'offset', a branch reaches at most 32 KiB ahead
+ * @param buffer Buffer to append the definition to
+*/
+void decoder_format_label_equ(const uint32_t offset, const uint32_t distance, output_buffer_t* const buffer);
+
+/**
+ * @brief Write a comment line describing a basic block, e.g. "; block 0000-0012 -> 0020 0012"
+ *
+ * @param start Offset of the first instruction of the block
+ * @param end Offset after the last instruction of the block
+ * @param successors Offsets of the blocks control can pass to
+ * @param successor_count Number of successors, at most a few
+ * @param buffer Buffer to append the comment to
+*/
+void decoder_format_block_comment(const uint32_t start, const uint32_t end, const uint32_t* const successors, const uint32_t successor_count, output_buffer_t* const buffer);
+
+/**
+ * @brief Write bytes as 'db' lines
+ *
+ * @param bytes Bytes to write
+ * @param count Number of bytes
+ * @param buffer Buffer to append the lines to
+*/
+void decoder_format_data(const uint8_t* const bytes, const uint32_t count, output_buffer_t* const buffer);
+
+/**
+ * @brief Get the mnemonic of an operation, without prefixes or size suffix
+*/
+const char* decoder_format_get_operation_name(const uint8_t operation);
+
+/**
+ * @brief Get the text of an effective address, e.g. "bp + si"
+*/
+const char* decoder_format_get_effective_address_name(const uint8_t effective_address);
+
+/**
+ * @brief Write the error line for an opcode the decoder doesn't know
+ *
+ * @param opcode First byte of the instruction
+ * @param buffer Buffer to append the error to
+*/
+void decoder_format_unknown_opcode(const uint8_t opcode, output_buffer_t* const buffer);
+
+/**
+ * @brief Write the error line for an instruction cut off by the end of the stream
+ *
+ * @param offset Offset of the first byte of the instruction
+ * @param buffer Buffer to append the error to
+*/
+void decoder_format_truncated_instruction(const uint64_t offset, output_buffer_t* const buffer);
+
+#endif
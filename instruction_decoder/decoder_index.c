@@ -0,0 +1,279 @@
+/*
+Copyright (c) 2023 Daniel Fedai Larsen
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "decoder_index.h"
+
+#include "decoder.h"
+#include "decoder_classify.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Instructions average about three bytes, start with room for that many */
+#define DECODER_INDEX_BYTES_PER_INSTRUCTION 3U
+#define DECODER_INDEX_MIN_CAPACITY 64U
+
+/* 64-bit FNV-1a */
+#define FNV_OFFSET_BASIS 0xCBF29CE484222325ULL
+#define FNV_PRIME 0x00000100000001B3ULL
+
+/**
+ * Start of a saved index, the offsets follow it. Values are in the byte order of the machine that saved it, a machine
+ * with a different byte order sees a bad magic number and builds its own index.
+*/
+typedef struct
+{
+    uint32_t magic;   /* DECODER_INDEX_FILE_MAGIC */
+    uint32_t version; /* DECODER_INDEX_FILE_VERSION */
+    uint64_t hash;    /* Hash of the stream */
+    uint32_t count;
+    uint32_t end;
+} decoder_index_file_header_t;
+
+bool decoder_index_build(decoder_index_t* const index, const uint8_t* const inst_stream, const uint32_t inst_stream_len)
+{
+    decoder_init();
+
+    index->capacity = (inst_stream_len / DECODER_INDEX_BYTES_PER_INSTRUCTION) + DECODER_INDEX_MIN_CAPACITY;
+    index->offsets = malloc(index->capacity * sizeof(uint32_t));
+    index->count = 0;
+
+    decoder_classifier_t classifier;
+    decoder_classifier_init(&classifier, inst_stream, inst_stream_len);
+    uint32_t offset = 0;
+    while (offset < inst_stream_len)
+    {
+        const uint32_t length = decoder_classifier_get_length(&classifier, offset);
+        if (length == 0)
+        {
+            break;
+        }
+
+        if (index->count == index->capacity)
+        {
+            index->capacity *= 2;
+            index->offsets = realloc(index->offsets, index->capacity * sizeof(uint32_t));
+        }
+        index->offsets[index->count] = offset;
+        index->count++;
+        offset += length;
+    }
+    index->end = offset;
+
+    return offset == inst_stream_len;
+}
+
+uint32_t decoder_index_build_bitmap(const uint8_t* const inst_stream, const uint32_t inst_stream_len, uint8_t* const bitmap)
+{
+    decoder_init();
+
+    memset(bitmap, 0, (inst_stream_len + 7) / 8);
+    decoder_classifier_t classifier;
+    decoder_classifier_init(&classifier, inst_stream, inst_stream_len);
+    uint32_t offset = 0;
+    while (offset < inst_stream_len)
+    {
+        const uint32_t length = decoder_classifier_get_length(&classifier, offset);
+        if (length == 0)
+        {
+            break;
+        }
+
+        bitmap[offset >> 3] |= (uint8_t)(1U << (offset & 0b111));
+        offset += length;
+    }
+
+    return offset;
+}
+
+uint32_t decoder_index_find(const decoder_index_t* const index, const uint32_t offset)
+{
+    if (offset >= index->end)
+    {
+        return index->count;
+    }
+
+    /* Last instruction starting at or before 'offset', the first one always starts at 0 */
+    uint32_t low = 0;
+    uint32_t high = index->count;
+    while ((high - low) > 1)
+    {
+        const uint32_t middle = low + ((high - low) / 2);
+        if (index->offsets[middle] <= offset)
+        {
+            low = middle;
+        }
+        else /* index->offsets[middle] > offset */
+        {
+            high = middle;
+        }
+    }
+
+    return low;
+}
+
+uint64_t decoder_index_hash(const uint8_t* const inst_stream, const uint32_t inst_stream_len)
+{
+    /* A word at a time, it only has to tell streams apart, not be the standard FNV-1a of the bytes */
+    uint64_t hash = FNV_OFFSET_BASIS ^ inst_stream_len;
+    uint32_t i = 0;
+    for (; (i + sizeof(uint64_t)) <= inst_stream_len; i += sizeof(uint64_t))
+    {
+        uint64_t word;
+        memcpy(&word, inst_stream + i, sizeof(uint64_t));
+        hash = (hash ^ word) * FNV_PRIME;
+    }
+    for (; i < inst_stream_len; i++)
+    {
+        hash = (hash ^ inst_stream[i]) * FNV_PRIME;
+    }
+
+    return hash;
+}
+
+bool decoder_index_save(const decoder_index_t* const index, const char* const path, const uint64_t hash)
+{
+    FILE* file = fopen(path, "wb");
+    if (file == NULL)
+    {
+        return false;
+    }
+
+    decoder_index_file_header_t header;
+    memset(&header, 0, sizeof(header));
+    header.magic = DECODER_INDEX_FILE_MAGIC;
+    header.version = DECODER_INDEX_FILE_VERSION;
+    header.hash = hash;
+    header.count = index->count;
+    header.end = index->end;
+    bool success = fwrite(&header, sizeof(header), 1, file) == 1;
+    if ((success == true) && (index->count > 0))
+    {
+        success = fwrite(index->offsets, sizeof(uint32_t), index->count, file) == index->count;
+    }
+    success = (fclose(file) == 0) && (success == true);
+
+    /* Don't leave a partial index behind */
+    if (success == false)
+    {
+        remove(path);
+    }
+    return success;
+}
+
+/**
+ * Check that loaded offsets could have come from scanning a stream of 'inst_stream_len' bytes: they start at 0, only
+ * increase and stop before 'end', which is inside the stream.
+*/
+static bool decoder_index_is_valid(const decoder_index_t* const index, const uint32_t inst_stream_len)
+{
+    if (index->end > inst_stream_len)
+    {
+        return false;
+    }
+    if (index->count == 0)
+    {
+        return index->end == 0;
+    }
+    if ((index->offsets[0] != 0) || (index->offsets[index->count - 1] >= index->end))
+    {
+        return false;
+    }
+
+    for (uint32_t i = 1; i < index->count; i++)
+    {
+        if (index->offsets[i] <= index->offsets[i - 1])
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool decoder_index_load(decoder_index_t* const index, const char* const path, const uint64_t hash, const uint32_t inst_stream_len)
+{
+    FILE* file = fopen(path, "rb");
+    if (file == NULL)
+    {
+        return false;
+    }
+
+    /* Every instruction takes at least a byte, a larger count can't be right and would only size the allocation */
+    decoder_index_file_header_t header;
+    if ((fread(&header, sizeof(header), 1, file) != 1) ||
+        (header.magic != DECODER_INDEX_FILE_MAGIC) ||
+        (header.version != DECODER_INDEX_FILE_VERSION) ||
+        (header.hash != hash) ||
+        (header.count > inst_stream_len))
+    {
+        fclose(file);
+        return false;
+    }
+
+    index->capacity = (header.count > 0) ? header.count : 1;
+    index->offsets = malloc(index->capacity * sizeof(uint32_t));
+    index->count = header.count;
+    index->end = header.end;
+    if (index->offsets == NULL)
+    {
+        index->capacity = 0;
+        index->count = 0;
+        fclose(file);
+        return false;
+    }
+
+    /* The file must hold exactly 'count' offsets */
+    if ((fread(index->offsets, sizeof(uint32_t), index->count, file) != index->count) ||
+        (fgetc(file) != EOF) ||
+        (decoder_index_is_valid(index, inst_stream_len) == false))
+    {
+        decoder_index_free(index);
+        fclose(file);
+        return false;
+    }
+
+    fclose(file);
+    return true;
+}
+
+void decoder_index_open(decoder_index_t* const index, const uint8_t* const inst_stream, const uint32_t inst_stream_len, const char* const path)
+{
+    const uint64_t hash = decoder_index_hash(inst_stream, inst_stream_len);
+    if (decoder_index_load(index, path, hash, inst_stream_len) == true)
+    {
+        return;
+    }
+
+    /* Saving is only a cache for next time, the index is usable either way */
+    decoder_index_build(index, inst_stream, inst_stream_len);
+    decoder_index_save(index, path, hash);
+}
+
+void decoder_index_free(decoder_index_t* const index)
+{
+    free(index->offsets);
+    index->offsets = NULL;
+    index->count = 0;
+    index->capacity = 0;
+}
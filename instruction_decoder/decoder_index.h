@@ -0,0 +1,117 @@
+/*
+Copyright (c) 2023 Daniel Fedai Larsen
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef DECODER_INDEX_H
+#define DECODER_INDEX_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Identifies a saved index, followed by the format version */
+#define DECODER_INDEX_FILE_MAGIC 0x58444938U /* "8IDX" */
+#define DECODER_INDEX_FILE_VERSION 1U
+
+/**
+ * Offsets of the instructions in a stream, found by looking only at instruction lengths. Building it is much cheaper
+ * than decoding the stream, and it tells where decoding can start anywhere in the stream.
+*/
+typedef struct
+{
+    uint32_t* offsets; /* Offset of the first byte of every instruction, in increasing order */
+    uint32_t count;    /* Number of instructions in 'offsets' */
+    uint32_t capacity;
+    uint32_t end;      /* Offset where the scan stopped, the stream length unless an instruction couldn't be decoded */
+} decoder_index_t;
+
+/**
+ * @brief Find where every instruction in a stream starts
+ *
+ * @param index Index to build, free it with 'decoder_index_free'
+ * @param inst_stream Stream of bytes with encoded instructions
+ * @param inst_stream_len Length of 'inst_stream' in bytes
+ * @return false if the scan stopped at an unknown opcode or a truncated instruction, 'end' is its offset
+*/
+bool decoder_index_build(decoder_index_t* const index, const uint8_t* const inst_stream, const uint32_t inst_stream_len);
+
+/**
+ * @brief Mark where every instruction in a stream starts, without allocating
+ *
+ * @param inst_stream Stream of bytes with encoded instructions
+ * @param inst_stream_len Length of 'inst_stream' in bytes
+ * @param bitmap One bit per byte of the stream, set if an instruction starts there. It must hold
+ *               (inst_stream_len + 7) / 8 bytes, bit N % 8 of byte N / 8 is for offset N
+ * @return Offset where the scan stopped, 'inst_stream_len' unless an instruction couldn't be decoded
+*/
+uint32_t decoder_index_build_bitmap(const uint8_t* const inst_stream, const uint32_t inst_stream_len, uint8_t* const bitmap);
+
+/**
+ * @brief Find the instruction that covers a byte, with a binary search
+ *
+ * @param index Index of the stream
+ * @param offset Offset of a byte in the stream
+ * @return Number of the instruction in 'offsets' that 'offset' is part of, 'count' if 'offset' is at or past 'end'
+*/
+uint32_t decoder_index_find(const decoder_index_t* const index, const uint32_t offset);
+
+/**
+ * @brief Hash the content of a stream, saved indices are only used for the stream they were built from
+*/
+uint64_t decoder_index_hash(const uint8_t* const inst_stream, const uint32_t inst_stream_len);
+
+/**
+ * @brief Write an index to a file
+ *
+ * @param index Index to save
+ * @param path File to write
+ * @param hash Hash of the stream the index was built from
+ * @return false if the file couldn't be written
+*/
+bool decoder_index_save(const decoder_index_t* const index, const char* const path, const uint64_t hash);
+
+/**
+ * @brief Read an index from a file
+ *
+ * @param index Index to load, free it with 'decoder_index_free'
+ * @param path File to read
+ * @param hash Hash of the stream the index is wanted for
+ * @param inst_stream_len Length of the stream, the offsets are checked against it
+ * @return false if the file is missing, damaged or was saved for a different stream
+*/
+bool decoder_index_load(decoder_index_t* const index, const char* const path, const uint64_t hash, const uint32_t inst_stream_len);
+
+/**
+ * @brief Load the index of a stream from a file next to it, or build and save it if there's no valid one
+ *
+ * @param index Index to load or build, free it with 'decoder_index_free'
+ * @param inst_stream Stream of bytes with encoded instructions
+ * @param inst_stream_len Length of 'inst_stream' in bytes
+ * @param path File the index is kept in
+*/
+void decoder_index_open(decoder_index_t* const index, const uint8_t* const inst_stream, const uint32_t inst_stream_len, const char* const path);
+
+/**
+ * @brief Free the offsets of an index
+*/
+void decoder_index_free(decoder_index_t* const index);
+
+#endif
@@ -0,0 +1,186 @@
+/*
+Copyright (c) 2023 Daniel Fedai Larsen
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "decoder_labels.h"
+
+#include "decoder_format.h"
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define DECODER_LABELS_MIN_CAPACITY 1024U
+/* Keeps the bitmap size within 32 bits, larger targets keep their relative form */
+#define DECODER_LABELS_MAX_TARGET (int64_t)(1U << 31)
+
+static bool labels_test(const decoder_labels_t* const labels, const uint32_t offset)
+{
+    return (offset < labels->target_capacity) && ((labels->targets[offset >> 3] & (1U << (offset & 0x7))) != 0);
+}
+
+static void labels_add_target(decoder_labels_t* const labels, const uint32_t target)
+{
+    if (target >= labels->target_capacity)
+    {
+        uint32_t capacity = labels->target_capacity * 2;
+        while (capacity <= target)
+        {
+            capacity *= 2;
+        }
+        labels->targets = realloc(labels->targets, capacity / 8);
+        memset(labels->targets + (labels->target_capacity / 8), 0, (capacity - labels->target_capacity) / 8);
+        labels->target_capacity = capacity;
+    }
+
+    labels->targets[target >> 3] |= (uint8_t)(1U << (target & 0x7));
+}
+
+/**
+ * Write the definitions of the labels from 'start' up to 'end', relative to the instruction or end of stream at
+ * 'start'.
+*/
+static void labels_format_range(const decoder_labels_t* const labels, const uint32_t start, const uint32_t end, output_buffer_t* const buffer)
+{
+    for (uint32_t offset = start; offset < end; offset++)
+    {
+        if (labels_test(labels, offset) == false)
+        {
+            continue;
+        }
+
+        if (offset == start)
+        {
+            decoder_format_label(offset, buffer);
+        }
+        else /* Inside the instruction */
+        {
+            decoder_format_label_equ(offset, offset - start, buffer);
+        }
+    }
+}
+
+void decoder_labels_init(decoder_labels_t* const labels, output_buffer_t* const buffer)
+{
+    labels->target_capacity = DECODER_LABELS_MIN_CAPACITY;
+    labels->targets = calloc(labels->target_capacity / 8, 1);
+    labels->inst_capacity = DECODER_LABELS_MIN_CAPACITY;
+    labels->inst_offsets = malloc(labels->inst_capacity * sizeof(uint32_t));
+    labels->text_positions = malloc(labels->inst_capacity * sizeof(uint32_t));
+    labels->inst_count = 0;
+    output_buffer_init(&labels->scratch, 0, NULL);
+
+    labels->file = buffer->file;
+    labels->write = buffer->write;
+    labels->write_context = buffer->write_context;
+    buffer->file = NULL;
+    buffer->write = NULL;
+}
+
+void decoder_labels_free(decoder_labels_t* const labels)
+{
+    free(labels->targets);
+    free(labels->inst_offsets);
+    free(labels->text_positions);
+    output_buffer_free(&labels->scratch);
+    labels->targets = NULL;
+    labels->inst_offsets = NULL;
+    labels->text_positions = NULL;
+    labels->target_capacity = 0;
+    labels->inst_count = 0;
+    labels->inst_capacity = 0;
+}
+
+void decoder_labels_format_instruction(decoder_labels_t* const labels, const uint32_t offset, const instruction_t* const inst, output_buffer_t* const buffer)
+{
+    if (labels->inst_count == labels->inst_capacity)
+    {
+        labels->inst_capacity *= 2;
+        labels->inst_offsets = realloc(labels->inst_offsets, labels->inst_capacity * sizeof(uint32_t));
+        labels->text_positions = realloc(labels->text_positions, labels->inst_capacity * sizeof(uint32_t));
+    }
+    labels->inst_offsets[labels->inst_count] = offset;
+    labels->text_positions[labels->inst_count] = buffer->size;
+    labels->inst_count++;
+
+    if (inst->operands[0].kind == OPERAND_RELATIVE)
+    {
+        /* Targets before the start of the stream can't have a label */
+        const int64_t target = (int64_t)offset + inst->length + (int16_t)inst->immediate;
+        if ((target >= 0) && (target < DECODER_LABELS_MAX_TARGET))
+        {
+            labels_add_target(labels, (uint32_t)target);
+            decoder_format_instruction_with_label(inst, (uint32_t)target, buffer);
+            return;
+        }
+    }
+
+    decoder_format_instruction(inst, buffer);
+}
+
+void decoder_labels_finish(decoder_labels_t* const labels, const uint32_t end, output_buffer_t* const buffer)
+{
+    /*
+     * Write the label lines of every instruction to the scratch buffer in order. The offsets aren't needed after this,
+     * their slots are reused for where the label lines of each instruction end in the scratch buffer.
+    */
+    output_buffer_t* const scratch = &labels->scratch;
+    scratch->size = 0;
+    uint32_t* const label_ends = labels->inst_offsets;
+    for (uint32_t i = 0; i < labels->inst_count; i++)
+    {
+        const uint32_t next_offset = ((i + 1) < labels->inst_count) ? labels->inst_offsets[i + 1] : end;
+        labels_format_range(labels, labels->inst_offsets[i], next_offset, scratch);
+        label_ends[i] = scratch->size;
+    }
+
+    /*
+     * Make room for all label lines at once, then move the text back from the end, so every byte is moved once. The
+     * text of an instruction moves by the size of all label lines up to and including its own.
+    */
+    output_buffer_reserve(buffer, scratch->size);
+    uint32_t text_end = buffer->size;
+    uint32_t label_end = scratch->size;
+    for (uint32_t i = labels->inst_count; (i > 0) && (label_end > 0); i--)
+    {
+        const uint32_t label_start = (i > 1) ? label_ends[i - 2] : 0;
+        if (label_start == label_end)
+        {
+            continue;
+        }
+
+        const uint32_t text_start = labels->text_positions[i - 1];
+        memmove(buffer->data + text_start + label_end, buffer->data + text_start, text_end - text_start);
+        memcpy(buffer->data + text_start + label_start, scratch->data + label_start, label_end - label_start);
+        text_end = text_start;
+        label_end = label_start;
+    }
+    buffer->size += scratch->size;
+
+    /* Targets past the end */
+    labels_format_range(labels, end, (labels->target_capacity > end) ? labels->target_capacity : end, buffer);
+    labels->inst_count = 0;
+
+    buffer->file = labels->file;
+    buffer->write = labels->write;
+    buffer->write_context = labels->write_context;
+}
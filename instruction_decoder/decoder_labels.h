@@ -0,0 +1,90 @@
+/*
+Copyright (c) 2023 Daniel Fedai Larsen
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef DECODER_LABELS_H
+#define DECODER_LABELS_H
+
+#include "instruction.h"
+#include "output_buffer.h"
+
+#include <stdint.h>
+#include <stdio.h>
+
+/**
+ * Labels for jump and call targets, collected while decoding a stream front to back in a single pass. Branches are
+ * written with the label of their target straight away. The lines defining the labels are spliced into the text once
+ * the stream ends, so the text stays in memory until then and is written to the file in one go.
+ *
+ * A target in the middle of an instruction, or past the end of the stream, is defined relative to the closest
+ * instruction with 'equ', so every label used has a definition.
+*/
+typedef struct
+{
+    uint8_t* targets;           /* One bit per offset, set where a jump or call goes */
+    uint32_t target_capacity;   /* Number of offsets 'targets' has room for, a multiple of 8 */
+    uint32_t* inst_offsets;     /* Offset of every instruction written */
+    uint32_t* text_positions;   /* Where the text of every instruction starts in the buffer */
+    uint32_t inst_count;
+    uint32_t inst_capacity;
+    output_buffer_t scratch;    /* Label lines while splicing */
+    FILE* file;                 /* Where the buffer's text goes, detached until the labels are spliced in */
+    output_buffer_write_t write;
+    void* write_context;
+} decoder_labels_t;
+
+/**
+ * @brief Start collecting labels for text written to a buffer
+ *
+ * The buffer's file or writer is detached until 'decoder_labels_finish' so no text is written before the labels are
+ * in place.
+ *
+ * @param labels Labels to initialize
+ * @param buffer Buffer the instructions will be written to
+*/
+void decoder_labels_init(decoder_labels_t* const labels, output_buffer_t* const buffer);
+
+/**
+ * @brief Free the collected labels, without touching the buffer
+*/
+void decoder_labels_free(decoder_labels_t* const labels);
+
+/**
+ * @brief Write a decoded instruction, with the label of its target if it's a relative jump or call
+ *
+ * @param labels Labels collected so far
+ * @param offset Offset of the instruction in the stream, must be larger than that of the previous instruction
+ * @param inst Decoded instruction
+ * @param buffer Buffer to append the formatted instruction to
+*/
+void decoder_labels_format_instruction(decoder_labels_t* const labels, const uint32_t offset, const instruction_t* const inst, output_buffer_t* const buffer);
+
+/**
+ * @brief Splice the label definitions into the text and attach the buffer's file or writer again
+ *
+ * @param labels Labels collected while decoding
+ * @param end Offset where decoding stopped, targets past it are defined at the end of the text
+ * @param buffer Buffer the instructions were written to
+*/
+void decoder_labels_finish(decoder_labels_t* const labels, const uint32_t end, output_buffer_t* const buffer);
+
+#endif
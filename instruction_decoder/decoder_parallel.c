@@ -0,0 +1,215 @@
+/*
+Copyright (c) 2023 Daniel Fedai Larsen
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "decoder_parallel.h"
+
+#include "decoder.h"
+#include "decoder_format.h"
+#include "decoder_stream.h"
+#include "thread.h"
+
+#include <stdbool.h>
+#include <stdlib.h>
+
+typedef struct
+{
+    const uint8_t* inst_stream;
+    uint32_t inst_stream_len;
+    uint32_t start;         /* Speculative offset of the first instruction */
+    uint32_t end;           /* Offset where the next segment starts */
+    uint32_t decoded_end;   /* Offset after the last decoded instruction */
+    uint32_t* inst_starts;  /* Offset of every decoded instruction */
+    uint32_t* text_starts;  /* Offset of every decoded instruction's text in 'buffer' */
+    uint32_t inst_count;
+    uint32_t inst_capacity;
+    output_buffer_t buffer;
+    thread_t thread;
+} decoder_segment_t;
+
+static void decoder_segment_add(decoder_segment_t* const segment, const uint32_t inst_start)
+{
+    if (segment->inst_count == segment->inst_capacity)
+    {
+        segment->inst_capacity = (segment->inst_capacity == 0) ? 1024 : segment->inst_capacity * 2;
+        segment->inst_starts = realloc(segment->inst_starts, segment->inst_capacity * sizeof(uint32_t));
+        segment->text_starts = realloc(segment->text_starts, segment->inst_capacity * sizeof(uint32_t));
+    }
+
+    segment->inst_starts[segment->inst_count] = inst_start;
+    segment->text_starts[segment->inst_count] = segment->buffer.size;
+    segment->inst_count++;
+}
+
+/**
+ * Worker decoding one segment. It stops at the end of the segment, at an unknown opcode or when fewer than
+ * INSTRUCTION_MAX_LENGTH bytes are left in the stream, the stitching takes care of all three.
+*/
+static void decoder_segment_decode(void* argument)
+{
+    decoder_segment_t* const segment = (decoder_segment_t*)argument;
+
+    uint32_t index = segment->start;
+    instruction_t inst;
+    while ((index < segment->end) && ((segment->inst_stream_len - index) >= INSTRUCTION_MAX_LENGTH))
+    {
+        if (decoder_decode_one(segment->inst_stream, segment->inst_stream_len, index, &inst) == false)
+        {
+            break;
+        }
+
+        decoder_segment_add(segment, index);
+        decoder_format_instruction(&inst, &segment->buffer);
+        index += inst.length;
+    }
+
+    segment->decoded_end = index;
+}
+
+/**
+ * Find the first instruction of 'segment' starting at or after 'offset'.
+*/
+static uint32_t decoder_segment_find(const decoder_segment_t* const segment, const uint32_t offset)
+{
+    uint32_t low = 0;
+    uint32_t high = segment->inst_count;
+    while (low < high)
+    {
+        const uint32_t middle = low + ((high - low) / 2);
+        if (segment->inst_starts[middle] < offset)
+        {
+            low = middle + 1;
+        }
+        else /* segment->inst_starts[middle] >= offset */
+        {
+            high = middle;
+        }
+    }
+
+    return low;
+}
+
+void decoder_decode_stream_parallel(const uint8_t* const inst_stream, const uint32_t inst_stream_len, uint32_t thread_count, output_buffer_t* const buffer)
+{
+    /* Make sure the workers don't race to build the tables */
+    decoder_init();
+
+    if (thread_count == 0)
+    {
+        thread_count = thread_get_processor_count();
+    }
+    const uint32_t max_thread_count = inst_stream_len / DECODER_PARALLEL_MIN_SEGMENT_SIZE;
+    if (thread_count > max_thread_count)
+    {
+        thread_count = max_thread_count;
+    }
+    if (thread_count <= 1)
+    {
+        decoder_decode_stream_to_buffer(inst_stream, inst_stream_len, buffer);
+        return;
+    }
+
+    /* Decode every segment speculatively */
+    decoder_segment_t* segments = calloc(thread_count, sizeof(decoder_segment_t));
+    for (uint32_t i = 0; i < thread_count; i++)
+    {
+        decoder_segment_t* const segment = &segments[i];
+        segment->inst_stream = inst_stream;
+        segment->inst_stream_len = inst_stream_len;
+        segment->start = (uint32_t)(((uint64_t)inst_stream_len * i) / thread_count);
+        segment->end = (uint32_t)(((uint64_t)inst_stream_len * (i + 1)) / thread_count);
+        output_buffer_init(&segment->buffer, OUTPUT_BUFFER_DEFAULT_CAPACITY, NULL);
+    }
+    for (uint32_t i = 1; i < thread_count; i++)
+    {
+        if (thread_create(&segments[i].thread, decoder_segment_decode, &segments[i]) == false)
+        {
+            /* Decode it here instead */
+            decoder_segment_decode(&segments[i]);
+            segments[i].thread.function = NULL;
+        }
+    }
+    decoder_segment_decode(&segments[0]);
+    for (uint32_t i = 1; i < thread_count; i++)
+    {
+        if (segments[i].thread.function != NULL)
+        {
+            thread_join(&segments[i].thread);
+        }
+    }
+
+    /* Stitch the segments together, following the true instruction boundaries from the start of the stream */
+    output_buffer_append_string(buffer, "bits 16\n\n");
+    uint32_t index = 0;
+    bool failed = false;
+    instruction_t inst;
+    for (uint32_t i = 0; (i < thread_count) && (failed == false); i++)
+    {
+        const decoder_segment_t* const segment = &segments[i];
+        uint32_t inst_index = decoder_segment_find(segment, index);
+        while ((index < segment->end) && ((inst_stream_len - index) >= INSTRUCTION_MAX_LENGTH))
+        {
+            /* Skip speculative boundaries that have been passed */
+            while ((inst_index < segment->inst_count) && (segment->inst_starts[inst_index] < index))
+            {
+                inst_index++;
+            }
+
+            /* Back in sync, the rest of the segment's output is correct */
+            if ((inst_index < segment->inst_count) && (segment->inst_starts[inst_index] == index))
+            {
+                const uint32_t text_start = segment->text_starts[inst_index];
+                output_buffer_append(buffer, segment->buffer.data + text_start, segment->buffer.size - text_start);
+                index = segment->decoded_end;
+                inst_index = segment->inst_count;
+                continue;
+            }
+
+            /* Not in sync yet, decode the gap */
+            if (decoder_decode_one(inst_stream, inst_stream_len, index, &inst) == false)
+            {
+                decoder_format_unknown_opcode(decoder_get_unknown_opcode(inst_stream + index, inst_stream_len - index), buffer);
+                failed = true;
+                break;
+            }
+            decoder_format_instruction(&inst, buffer);
+            index += inst.length;
+        }
+    }
+
+    /* The last few bytes might hold a truncated instruction, let the stream decoder deal with them */
+    if ((failed == false) && (index < inst_stream_len))
+    {
+        decoder_stream_t stream;
+        decoder_stream_init_at(&stream, buffer, index);
+        decoder_stream_feed(&stream, inst_stream + index, inst_stream_len - index);
+        decoder_stream_finish(&stream);
+    }
+
+    for (uint32_t i = 0; i < thread_count; i++)
+    {
+        output_buffer_free(&segments[i].buffer);
+        free(segments[i].inst_starts);
+        free(segments[i].text_starts);
+    }
+    free(segments);
+}
@@ -0,0 +1,49 @@
+/*
+Copyright (c) 2023 Daniel Fedai Larsen
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef DECODER_PARALLEL_H
+#define DECODER_PARALLEL_H
+
+#include "output_buffer.h"
+
+#include <stdint.h>
+
+/* Streams are only split when every segment gets at least this many bytes */
+#define DECODER_PARALLEL_MIN_SEGMENT_SIZE (uint32_t)(1U << 16)
+
+/**
+ * @brief Decode a stream on several threads, the output is identical to 'decoder_decode_stream_to_buffer'
+ *
+ * The stream is split into one segment per thread and every segment is decoded from its first byte, which might be in
+ * the middle of an instruction. The segments are then stitched together in order: where the true instruction
+ * boundaries coming from the previous segment meet one of the segment's own boundaries its output is used as is,
+ * only the instructions before that point are decoded again.
+ *
+ * @param inst_stream Stream of bytes with encoded instructions
+ * @param inst_stream_len Length of 'inst_stream' in bytes
+ * @param thread_count Number of threads to use, 0 uses one per processor
+ * @param buffer Buffer to append decoded instructions to
+*/
+void decoder_decode_stream_parallel(const uint8_t* const inst_stream, const uint32_t inst_stream_len, uint32_t thread_count, output_buffer_t* const buffer);
+
+#endif
@@ -0,0 +1,83 @@
+/*
+Copyright (c) 2023 Daniel Fedai Larsen
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "decoder_range.h"
+
+#include "decoder.h"
+#include "decoder_format.h"
+
+/**
+ * Decode instructions from 'offset' until 'count' of them have been written or 'end' is reached.
+*/
+static bool decoder_range_decode(const uint8_t* const inst_stream, const uint32_t inst_stream_len, uint32_t offset, const uint32_t end, uint32_t count, output_buffer_t* const buffer)
+{
+    instruction_t inst;
+    while ((count > 0) && (offset < end))
+    {
+        if (decoder_decode_one(inst_stream, inst_stream_len, offset, &inst) == false)
+        {
+            if (inst.operation == OPERATION_NONE)
+            {
+                decoder_format_unknown_opcode(decoder_get_unknown_opcode(inst_stream + offset, inst_stream_len - offset), buffer);
+            }
+            else /* Truncated */
+            {
+                decoder_format_truncated_instruction(offset, buffer);
+            }
+            return false;
+        }
+
+        decoder_format_instruction(&inst, buffer);
+        offset += inst.length;
+        count--;
+    }
+
+    return true;
+}
+
+bool decoder_range_decode_instructions(const uint8_t* const inst_stream, const uint32_t inst_stream_len, const decoder_index_t* const index, const uint32_t first, const uint32_t last, output_buffer_t* const buffer)
+{
+    /* The instruction after the last indexed one is where the scan failed, include it so the error is reported */
+    const uint32_t count = (index->end < inst_stream_len) ? (index->count + 1) : index->count;
+    const uint32_t clamped_last = (last < count) ? last : count;
+    if (first >= clamped_last)
+    {
+        return true;
+    }
+
+    const uint32_t offset = (first < index->count) ? index->offsets[first] : index->end;
+    return decoder_range_decode(inst_stream, inst_stream_len, offset, inst_stream_len, clamped_last - first, buffer);
+}
+
+bool decoder_range_decode_bytes(const uint8_t* const inst_stream, const uint32_t inst_stream_len, const decoder_index_t* const index, const uint32_t begin, const uint32_t end, output_buffer_t* const buffer)
+{
+    const uint32_t clamped_end = (end < inst_stream_len) ? end : inst_stream_len;
+    if (begin >= clamped_end)
+    {
+        return true;
+    }
+
+    const uint32_t first = decoder_index_find(index, begin);
+    const uint32_t offset = (first < index->count) ? index->offsets[first] : index->end;
+    return decoder_range_decode(inst_stream, inst_stream_len, offset, clamped_end, UINT32_MAX, buffer);
+}
@@ -0,0 +1,59 @@
+/*
+Copyright (c) 2023 Daniel Fedai Larsen
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef DECODER_RANGE_H
+#define DECODER_RANGE_H
+
+#include "decoder_index.h"
+#include "output_buffer.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @brief Decode the instructions numbered 'first' up to, but not including, 'last'
+ *
+ * @param inst_stream Stream of bytes with encoded instructions
+ * @param inst_stream_len Length of 'inst_stream' in bytes
+ * @param index Boundary index of 'inst_stream'
+ * @param first Number of the first instruction to decode
+ * @param last Number of the instruction to stop at, it's clamped to the number of instructions
+ * @param buffer Buffer to append decoded instructions to
+ * @return false if the range reaches an unknown opcode or a truncated instruction, the error is written instead
+*/
+bool decoder_range_decode_instructions(const uint8_t* const inst_stream, const uint32_t inst_stream_len, const decoder_index_t* const index, const uint32_t first, const uint32_t last, output_buffer_t* const buffer);
+
+/**
+ * @brief Decode the instructions that overlap the bytes from 'begin' up to, but not including, 'end'
+ *
+ * @param inst_stream Stream of bytes with encoded instructions
+ * @param inst_stream_len Length of 'inst_stream' in bytes
+ * @param index Boundary index of 'inst_stream'
+ * @param begin Offset of the first byte, decoding starts at the instruction it's part of
+ * @param end Offset to stop at, it's clamped to 'inst_stream_len'
+ * @param buffer Buffer to append decoded instructions to
+ * @return false if the range reaches an unknown opcode or a truncated instruction, the error is written instead
+*/
+bool decoder_range_decode_bytes(const uint8_t* const inst_stream, const uint32_t inst_stream_len, const decoder_index_t* const index, const uint32_t begin, const uint32_t end, output_buffer_t* const buffer);
+
+#endif
@@ -0,0 +1,84 @@
+/*
+Copyright (c) 2023 Daniel Fedai Larsen
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "decoder_sink.h"
+
+#include <stdint.h>
+
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <errno.h>
+#include <unistd.h>
+#endif
+
+static void decoder_sink_write_memory(void* const context, const char* const data, const uint32_t len)
+{
+    output_buffer_append((output_buffer_t*)context, data, len);
+}
+
+static void decoder_sink_write_fd(void* const context, const char* const data, const uint32_t len)
+{
+    const int fd = (int)(intptr_t)context;
+
+    /* Writes can be cut short by signals and pipes, keep going until everything is written or it fails */
+    uint32_t written = 0;
+    while (written < len)
+    {
+#if defined(_WIN32)
+        const int result = _write(fd, data + written, len - written);
+#else
+        const ssize_t result = write(fd, data + written, len - written);
+        if ((result < 0) && (errno == EINTR))
+        {
+            continue;
+        }
+#endif
+        if (result <= 0)
+        {
+            return;
+        }
+        written += (uint32_t)result;
+    }
+}
+
+void decoder_sink_init_records(decoder_sink_t* const sink, const decoder_stream_record_t record, void* const context)
+{
+    sink->record = record;
+    sink->write = NULL;
+    sink->context = context;
+}
+
+void decoder_sink_init_memory(decoder_sink_t* const sink, output_buffer_t* const memory)
+{
+    sink->record = NULL;
+    sink->write = decoder_sink_write_memory;
+    sink->context = memory;
+}
+
+void decoder_sink_init_fd(decoder_sink_t* const sink, const int fd)
+{
+    sink->record = NULL;
+    sink->write = decoder_sink_write_fd;
+    sink->context = (void*)(intptr_t)fd;
+}
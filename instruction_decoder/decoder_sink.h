@@ -0,0 +1,66 @@
+/*
+Copyright (c) 2023 Daniel Fedai Larsen
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef DECODER_SINK_H
+#define DECODER_SINK_H
+
+#include "decoder_stream.h"
+#include "output_buffer.h"
+
+/**
+ * Where a decoder context sends its output. Decoded instructions go to 'record' as they're decoded, the assembly text
+ * goes to 'write' in large pieces. Either can be NULL, without 'write' no text is formatted at all.
+*/
+typedef struct
+{
+    decoder_stream_record_t record;
+    output_buffer_write_t write;
+    void* context;                  /* Passed to both functions */
+} decoder_sink_t;
+
+/**
+ * @brief Make a sink that only receives decoded instructions, no text is formatted
+ *
+ * @param sink Sink to initialize
+ * @param record Function receiving every decoded instruction
+ * @param context Passed to 'record'
+*/
+void decoder_sink_init_records(decoder_sink_t* const sink, const decoder_stream_record_t record, void* const context);
+
+/**
+ * @brief Make a sink that appends the text to an in-memory buffer
+ *
+ * @param sink Sink to initialize
+ * @param memory Buffer without a file, must outlive the sink
+*/
+void decoder_sink_init_memory(decoder_sink_t* const sink, output_buffer_t* const memory);
+
+/**
+ * @brief Make a sink that writes the text to a file descriptor, without going through stdio
+ *
+ * @param sink Sink to initialize
+ * @param fd Open file descriptor, stays owned by the caller
+*/
+void decoder_sink_init_fd(decoder_sink_t* const sink, const int fd);
+
+#endif
@@ -0,0 +1,194 @@
+/*
+Copyright (c) 2023 Daniel Fedai Larsen
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "decoder_stats.h"
+
+#include "decoder_format.h"
+
+#include <stdio.h>
+#include <string.h>
+
+static bool decoder_stats_is_prefix(const uint8_t byte)
+{
+    return (byte == 0xF0) || (byte == 0xF2) || (byte == 0xF3) || ((byte & 0xE7) == 0x26);
+}
+
+void decoder_stats_init(decoder_stats_t* const stats)
+{
+    memset(stats, 0, sizeof(decoder_stats_t));
+}
+
+void decoder_stats_add_instruction(decoder_stats_t* const stats, const uint8_t* const inst_bytes, const instruction_t* const inst, const uint64_t cycles)
+{
+    uint32_t opcode_index = 0;
+    while ((opcode_index < INSTRUCTION_MAX_PREFIX_COUNT) && (decoder_stats_is_prefix(inst_bytes[opcode_index]) == true))
+    {
+        stats->prefix_counts[inst_bytes[opcode_index]]++;
+        opcode_index++;
+    }
+
+    stats->inst_count++;
+    stats->bytes += inst->length;
+    stats->opcode_counts[inst_bytes[opcode_index]]++;
+
+    decoder_stats_operation_t* const operation = &stats->operations[inst->operation];
+    operation->count++;
+    operation->bytes += inst->length;
+    if (cycles > 0)
+    {
+        operation->samples++;
+        operation->cycles += cycles;
+    }
+}
+
+void decoder_stats_add_unknown(decoder_stats_t* const stats, const uint64_t offset)
+{
+    if (stats->unknown_count < DECODER_STATS_MAX_UNKNOWN_OFFSETS)
+    {
+        stats->unknown_offsets[stats->unknown_count] = offset;
+    }
+    stats->unknown_count++;
+}
+
+static void decoder_stats_format_table(const decoder_stats_t* const stats, output_buffer_t* const buffer)
+{
+    char line[160];
+    snprintf(line, sizeof(line), "[STATS] Instructions %llu, bytes %llu, unknown opcodes %llu, truncated %llu\n",
+             (unsigned long long)stats->inst_count, (unsigned long long)stats->bytes, (unsigned long long)stats->unknown_count,
+             (unsigned long long)stats->truncated_count);
+    output_buffer_append_string(buffer, line);
+
+    output_buffer_append_string(buffer, "\nOperation        Count        Bytes   Samples  Cycles/inst\n");
+    for (uint32_t i = 0; i < OPERATION_COUNT; i++)
+    {
+        const decoder_stats_operation_t* const operation = &stats->operations[i];
+        if (operation->count == 0)
+        {
+            continue;
+        }
+        const double cycles = (operation->samples > 0) ? ((double)operation->cycles / (double)operation->samples) : 0.0;
+        snprintf(line, sizeof(line), "%-10s %12llu %12llu %9llu %12.1f\n", decoder_format_get_operation_name((uint8_t)i),
+                 (unsigned long long)operation->count, (unsigned long long)operation->bytes,
+                 (unsigned long long)operation->samples, cycles);
+        output_buffer_append_string(buffer, line);
+    }
+
+    output_buffer_append_string(buffer, "\nOpcode        Count\n");
+    for (uint32_t i = 0; i < 256; i++)
+    {
+        if (stats->opcode_counts[i] > 0)
+        {
+            snprintf(line, sizeof(line), "0x%02X   %12llu\n", i, (unsigned long long)stats->opcode_counts[i]);
+            output_buffer_append_string(buffer, line);
+        }
+    }
+    for (uint32_t i = 0; i < 256; i++)
+    {
+        if (stats->prefix_counts[i] > 0)
+        {
+            snprintf(line, sizeof(line), "0x%02X   %12llu (prefix)\n", i, (unsigned long long)stats->prefix_counts[i]);
+            output_buffer_append_string(buffer, line);
+        }
+    }
+
+    if (stats->unknown_count > 0)
+    {
+        output_buffer_append_string(buffer, "\nUnknown opcodes at offsets");
+        for (uint64_t i = 0; (i < stats->unknown_count) && (i < DECODER_STATS_MAX_UNKNOWN_OFFSETS); i++)
+        {
+            snprintf(line, sizeof(line), " %llu", (unsigned long long)stats->unknown_offsets[i]);
+            output_buffer_append_string(buffer, line);
+        }
+        output_buffer_append_string(buffer, (stats->unknown_count > DECODER_STATS_MAX_UNKNOWN_OFFSETS) ? " ...\n" : "\n");
+    }
+}
+
+static void decoder_stats_format_json(const decoder_stats_t* const stats, output_buffer_t* const buffer)
+{
+    char line[200];
+    snprintf(line, sizeof(line), "{\n  \"instructions\": %llu,\n  \"bytes\": %llu,\n  \"unknown_count\": %llu,\n  \"truncated_count\": %llu,\n",
+             (unsigned long long)stats->inst_count, (unsigned long long)stats->bytes, (unsigned long long)stats->unknown_count,
+             (unsigned long long)stats->truncated_count);
+    output_buffer_append_string(buffer, line);
+
+    output_buffer_append_string(buffer, "  \"unknown_offsets\": [");
+    for (uint64_t i = 0; (i < stats->unknown_count) && (i < DECODER_STATS_MAX_UNKNOWN_OFFSETS); i++)
+    {
+        snprintf(line, sizeof(line), "%s%llu", (i == 0) ? "" : ", ", (unsigned long long)stats->unknown_offsets[i]);
+        output_buffer_append_string(buffer, line);
+    }
+    output_buffer_append_string(buffer, "],\n  \"operations\": [");
+
+    bool is_first = true;
+    for (uint32_t i = 0; i < OPERATION_COUNT; i++)
+    {
+        const decoder_stats_operation_t* const operation = &stats->operations[i];
+        if (operation->count == 0)
+        {
+            continue;
+        }
+        const double cycles = (operation->samples > 0) ? ((double)operation->cycles / (double)operation->samples) : 0.0;
+        snprintf(line, sizeof(line), "%s\n    {\"name\": \"%s\", \"count\": %llu, \"bytes\": %llu, \"samples\": %llu, \"cycles_per_instruction\": %.1f}",
+                 (is_first == true) ? "" : ",", decoder_format_get_operation_name((uint8_t)i), (unsigned long long)operation->count,
+                 (unsigned long long)operation->bytes, (unsigned long long)operation->samples, cycles);
+        output_buffer_append_string(buffer, line);
+        is_first = false;
+    }
+    output_buffer_append_string(buffer, "\n  ],\n  \"opcodes\": {");
+
+    is_first = true;
+    for (uint32_t i = 0; i < 256; i++)
+    {
+        if (stats->opcode_counts[i] > 0)
+        {
+            snprintf(line, sizeof(line), "%s\"0x%02X\": %llu", (is_first == true) ? "" : ", ", i, (unsigned long long)stats->opcode_counts[i]);
+            output_buffer_append_string(buffer, line);
+            is_first = false;
+        }
+    }
+    output_buffer_append_string(buffer, "},\n  \"prefixes\": {");
+
+    is_first = true;
+    for (uint32_t i = 0; i < 256; i++)
+    {
+        if (stats->prefix_counts[i] > 0)
+        {
+            snprintf(line, sizeof(line), "%s\"0x%02X\": %llu", (is_first == true) ? "" : ", ", i, (unsigned long long)stats->prefix_counts[i]);
+            output_buffer_append_string(buffer, line);
+            is_first = false;
+        }
+    }
+    output_buffer_append_string(buffer, "}\n}\n");
+}
+
+void decoder_stats_format(const decoder_stats_t* const stats, const bool as_json, output_buffer_t* const buffer)
+{
+    if (as_json == true)
+    {
+        decoder_stats_format_json(stats, buffer);
+    }
+    else /* Table */
+    {
+        decoder_stats_format_table(stats, buffer);
+    }
+}
@@ -0,0 +1,98 @@
+/*
+Copyright (c) 2023 Daniel Fedai Larsen
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef DECODER_STATS_H
+#define DECODER_STATS_H
+
+#include "instruction.h"
+#include "output_buffer.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Decode statistics are only collected when the decoder is built with DECODER_STATS defined. Without it the hooks in
+ * the stream decoder compile to nothing and decoder_stream_t has no 'stats' field.
+*/
+
+/* One in this many instructions is timed, must be a power of two */
+#define DECODER_STATS_SAMPLE_INTERVAL 64U
+/* Offsets of the first unknown opcodes are kept, later ones are only counted */
+#define DECODER_STATS_MAX_UNKNOWN_OFFSETS 16U
+
+/**
+ * Counts for one operation, which is decoded and formatted by the same spec entries.
+*/
+typedef struct
+{
+    uint64_t count;
+    uint64_t bytes;
+    uint64_t samples;       /* Number of timed instructions */
+    uint64_t cycles;        /* Cycles spent decoding and formatting the timed instructions */
+} decoder_stats_operation_t;
+
+typedef struct
+{
+    uint64_t inst_count;
+    uint64_t bytes;
+    uint64_t opcode_counts[256];        /* Indexed by the first byte after the prefixes */
+    uint64_t prefix_counts[256];        /* Indexed by the prefix byte */
+    decoder_stats_operation_t operations[OPERATION_COUNT];
+    uint64_t unknown_count;
+    uint64_t unknown_offsets[DECODER_STATS_MAX_UNKNOWN_OFFSETS];
+    uint64_t truncated_count;
+} decoder_stats_t;
+
+/**
+ * @brief Clear all counts
+*/
+void decoder_stats_init(decoder_stats_t* const stats);
+
+/**
+ * @brief Count a decoded instruction
+ *
+ * @param stats Stats to update
+ * @param inst_bytes Bytes of the instruction, prefixes included
+ * @param inst Decoded instruction
+ * @param cycles Cycles spent decoding and formatting it, 0 if it wasn't timed
+*/
+void decoder_stats_add_instruction(decoder_stats_t* const stats, const uint8_t* const inst_bytes, const instruction_t* const inst, const uint64_t cycles);
+
+/**
+ * @brief Count an unknown opcode
+ *
+ * @param stats Stats to update
+ * @param offset Offset of the instruction in the stream
+*/
+void decoder_stats_add_unknown(decoder_stats_t* const stats, const uint64_t offset);
+
+/**
+ * @brief Write a report of the stats
+ *
+ * @param stats Stats to report
+ * @param as_json true for a JSON object, false for a table
+ * @param buffer Buffer to write to
+*/
+void decoder_stats_format(const decoder_stats_t* const stats, const bool as_json, output_buffer_t* const buffer);
+
+#endif
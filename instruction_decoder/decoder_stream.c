@@ -0,0 +1,254 @@
+/*
+Copyright (c) 2023 Daniel Fedai Larsen
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "decoder_stream.h"
+
+#include "decoder.h"
+#include "decoder_format.h"
+
+#if defined(DECODER_STATS)
+#include "timer.h"
+#endif
+
+#include <string.h>
+
+static void decoder_stream_unknown_opcode(decoder_stream_t* const stream, const uint8_t* const bytes, const uint32_t len)
+{
+    const uint8_t opcode = decoder_get_unknown_opcode(bytes, len);
+
+#if defined(DECODER_STATS)
+    if (stream->stats != NULL)
+    {
+        decoder_stats_add_unknown(stream->stats, stream->offset);
+    }
+#endif
+
+    if (stream->buffer != NULL)
+    {
+        decoder_format_unknown_opcode(opcode, stream->buffer);
+    }
+    stream->failed = true;
+}
+
+/**
+ * Decode a single instruction and write it, through the cache when the stream has one.
+*/
+static bool decoder_stream_decode_and_format(decoder_stream_t* const stream, const uint8_t* const inst_stream, const uint32_t inst_stream_len, const uint32_t inst_stream_index, instruction_t* const inst)
+{
+    if (stream->buffer == NULL)
+    {
+        return decoder_decode_one(inst_stream, inst_stream_len, inst_stream_index, inst);
+    }
+
+    if (stream->labels != NULL)
+    {
+        if (decoder_decode_one(inst_stream, inst_stream_len, inst_stream_index, inst) == false)
+        {
+            return false;
+        }
+        decoder_labels_format_instruction(stream->labels, (uint32_t)stream->offset, inst, stream->buffer);
+        return true;
+    }
+
+    if (stream->cache != NULL)
+    {
+        return decoder_cache_decode(stream->cache, inst_stream, inst_stream_len, inst_stream_index, inst, stream->buffer);
+    }
+
+    if (decoder_decode_one(inst_stream, inst_stream_len, inst_stream_index, inst) == false)
+    {
+        return false;
+    }
+    decoder_format_instruction(inst, stream->buffer);
+
+    return true;
+}
+
+static bool decoder_stream_decode_one(decoder_stream_t* const stream, const uint8_t* const inst_stream, const uint32_t inst_stream_len, const uint32_t inst_stream_index, instruction_t* const inst)
+{
+#if defined(DECODER_STATS)
+    if (stream->stats != NULL)
+    {
+        /* Only time a sample, reading the counter costs about as much as decoding a short instruction */
+        const bool is_sampled = (stream->stats->inst_count & (DECODER_STATS_SAMPLE_INTERVAL - 1)) == 0;
+        const uint64_t start = (is_sampled == true) ? timer_get_cycles() : 0;
+        if (decoder_stream_decode_and_format(stream, inst_stream, inst_stream_len, inst_stream_index, inst) == false)
+        {
+            return false;
+        }
+        const uint64_t cycles = (is_sampled == true) ? (timer_get_cycles() - start) : 0;
+        decoder_stats_add_instruction(stream->stats, inst_stream + inst_stream_index, inst, cycles);
+        return true;
+    }
+#endif
+
+    return decoder_stream_decode_and_format(stream, inst_stream, inst_stream_len, inst_stream_index, inst);
+}
+
+/**
+ * Pass a decoded instruction on and move past it.
+*/
+static void decoder_stream_advance(decoder_stream_t* const stream, const instruction_t* const inst)
+{
+    if (stream->record != NULL)
+    {
+        stream->record(stream->record_context, stream->offset, inst);
+    }
+    stream->offset += inst->length;
+}
+
+/**
+ * Decode instructions starting in 'pending', taking bytes from the start of 'chunk' when they run past it. Returns the
+ * number of bytes taken from 'chunk'.
+*/
+static uint32_t decoder_stream_decode_pending(decoder_stream_t* const stream, const uint8_t* const chunk, const uint32_t chunk_len)
+{
+    uint32_t index = 0;
+    instruction_t inst;
+    while ((stream->pending_len > 0) && (stream->failed == false))
+    {
+        /* Top up the pending bytes, they're only kept if the instruction still doesn't fit */
+        uint32_t take = INSTRUCTION_MAX_LENGTH - stream->pending_len;
+        if (take > (chunk_len - index))
+        {
+            take = chunk_len - index;
+        }
+        if (take > 0)
+        {
+            memcpy(stream->pending + stream->pending_len, chunk + index, take);
+        }
+        const uint32_t available = stream->pending_len + take;
+
+        if (decoder_stream_decode_one(stream, stream->pending, available, 0, &inst) == false)
+        {
+            if (inst.operation == OPERATION_NONE)
+            {
+                decoder_stream_unknown_opcode(stream, stream->pending, available);
+            }
+            else /* Truncated, fewer than INSTRUCTION_MAX_LENGTH bytes available means the chunk is used up */
+            {
+                stream->pending_len = (uint8_t)available;
+                index += take;
+            }
+            break;
+        }
+
+        decoder_stream_advance(stream, &inst);
+        if (inst.length >= stream->pending_len)
+        {
+            index += inst.length - stream->pending_len;
+            stream->pending_len = 0;
+        }
+        else /* inst.length < stream->pending_len */
+        {
+            stream->pending_len -= inst.length;
+            memmove(stream->pending, stream->pending + inst.length, stream->pending_len);
+        }
+    }
+
+    return index;
+}
+
+void decoder_stream_init(decoder_stream_t* const stream, output_buffer_t* const buffer)
+{
+    if (buffer != NULL)
+    {
+        output_buffer_append_string(buffer, "bits 16\n\n");
+    }
+    decoder_stream_init_at(stream, buffer, 0);
+}
+
+void decoder_stream_init_at(decoder_stream_t* const stream, output_buffer_t* const buffer, const uint64_t offset)
+{
+    stream->offset = offset;
+    stream->pending_len = 0;
+    stream->failed = false;
+    stream->buffer = buffer;
+    stream->record = NULL;
+    stream->record_context = NULL;
+    stream->cache = NULL;
+    stream->labels = NULL;
+#if defined(DECODER_STATS)
+    stream->stats = NULL;
+#endif
+}
+
+bool decoder_stream_feed(decoder_stream_t* const stream, const uint8_t* const chunk, const uint32_t chunk_len)
+{
+    if (stream->failed == true)
+    {
+        return false;
+    }
+
+    /* Finish what's left from the previous chunk */
+    uint32_t index = decoder_stream_decode_pending(stream, chunk, chunk_len);
+
+    /* Decode in place while a whole instruction is guaranteed to fit */
+    instruction_t inst;
+    while ((stream->failed == false) && ((chunk_len - index) >= INSTRUCTION_MAX_LENGTH))
+    {
+        if (decoder_stream_decode_one(stream, chunk, chunk_len, index, &inst) == false)
+        {
+            decoder_stream_unknown_opcode(stream, chunk + index, chunk_len - index);
+            break;
+        }
+
+        decoder_stream_advance(stream, &inst);
+        index += inst.length;
+    }
+
+    /* Keep the tail for the next chunk */
+    if ((stream->failed == false) && (index < chunk_len))
+    {
+        stream->pending_len = (uint8_t)(chunk_len - index);
+        memcpy(stream->pending, chunk + index, stream->pending_len);
+        decoder_stream_decode_pending(stream, NULL, 0);
+    }
+
+    return stream->failed == false;
+}
+
+bool decoder_stream_finish(decoder_stream_t* const stream)
+{
+    if ((stream->failed == false) && (stream->pending_len > 0))
+    {
+#if defined(DECODER_STATS)
+        if (stream->stats != NULL)
+        {
+            stream->stats->truncated_count++;
+        }
+#endif
+        if (stream->buffer != NULL)
+        {
+            decoder_format_truncated_instruction(stream->offset, stream->buffer);
+        }
+        stream->failed = true;
+    }
+
+    if ((stream->labels != NULL) && (stream->buffer != NULL))
+    {
+        decoder_labels_finish(stream->labels, (uint32_t)stream->offset, stream->buffer);
+    }
+
+    return stream->failed == false;
+}
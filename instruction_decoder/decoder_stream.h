@@ -0,0 +1,96 @@
+/*
+Copyright (c) 2023 Daniel Fedai Larsen
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef DECODER_STREAM_H
+#define DECODER_STREAM_H
+
+#include "decoder_cache.h"
+#include "decoder_labels.h"
+#include "decoder_stats.h"
+#include "instruction.h"
+#include "output_buffer.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * Receives every decoded instruction with its offset from the start of the stream.
+*/
+typedef void (*decoder_stream_record_t)(void* const context, const uint64_t offset, const instruction_t* const inst);
+
+/**
+ * Resumable decoder for input that arrives in chunks. An instruction split across two chunks is kept in 'pending'
+ * until the rest of it arrives, so chunks can have any size and memory use stays constant.
+*/
+typedef struct
+{
+    uint64_t offset;                        /* Offset of the next instruction from the start of the stream */
+    uint8_t pending[INSTRUCTION_MAX_LENGTH]; /* Start of an instruction that didn't fit in the last chunk */
+    uint8_t pending_len;
+    bool failed;                            /* Set once an error has been written, all later input is ignored */
+    output_buffer_t* buffer;                /* NULL to decode without writing text */
+    decoder_stream_record_t record;         /* Optional, called for every decoded instruction */
+    void* record_context;
+    decoder_cache_t* cache;                 /* Optional cache of decoded instructions, NULL to decode every one */
+    decoder_labels_t* labels;               /* Optional labels for branch targets, takes the place of the cache */
+#if defined(DECODER_STATS)
+    decoder_stats_t* stats;                 /* Optional decode statistics, NULL to collect none */
+#endif
+} decoder_stream_t;
+
+/**
+ * @brief Start decoding a new stream, writes the assembly header
+ *
+ * @param stream Stream to initialize
+ * @param buffer Buffer to append decoded instructions to, or NULL for no text
+*/
+void decoder_stream_init(decoder_stream_t* const stream, output_buffer_t* const buffer);
+
+/**
+ * @brief Continue decoding in the middle of a stream, no header is written
+ *
+ * @param stream Stream to initialize
+ * @param buffer Buffer to append decoded instructions to, or NULL for no text
+ * @param offset Offset of the first byte that will be fed, used in error messages
+*/
+void decoder_stream_init_at(decoder_stream_t* const stream, output_buffer_t* const buffer, const uint64_t offset);
+
+/**
+ * @brief Decode the next chunk of the stream
+ *
+ * @param stream Stream the chunk belongs to
+ * @param chunk Next bytes of the stream
+ * @param chunk_len Length of 'chunk' in bytes
+ * @return false if an unknown opcode was found, in this or an earlier chunk
+*/
+bool decoder_stream_feed(decoder_stream_t* const stream, const uint8_t* const chunk, const uint32_t chunk_len);
+
+/**
+ * @brief Mark the end of the stream, splices in the label definitions when collecting labels
+ *
+ * @param stream Stream to finish
+ * @return false if decoding failed or the stream ended in the middle of an instruction
+*/
+bool decoder_stream_finish(decoder_stream_t* const stream);
+
+#endif
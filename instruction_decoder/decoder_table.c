@@ -0,0 +1,185 @@
+/*
+Copyright (c) 2023 Daniel Fedai Larsen
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "decoder_table.h"
+
+#define SPEC(operation, pattern, reg, w, flags, destination, source) \
+    { OPERATION_##operation, pattern, reg, w, flags, { OPERAND_TEMPLATE_##destination, OPERAND_TEMPLATE_##source } }
+
+#define NO_REG SPEC_NO_REG
+#define FAR SPEC_FLAG_FAR
+#define SUFFIX SPEC_FLAG_WIDTH_SUFFIX
+#define NO_SIZE SPEC_FLAG_NO_SIZE
+#define PREFIX SPEC_FLAG_PREFIX
+
+/**
+ * See Table 4-12 in the manual. Encodings sharing a first byte must either all be selected by REG or be a single entry.
+*/
+const instruction_spec_t instruction_specs[] = {
+    /* Data transfer */
+    SPEC(MOV,    "100010dw", NO_REG, 0, 0,       REG,         RM),
+    SPEC(MOV,    "1100011w", 0,      0, 0,       RM,          IMM),
+    SPEC(MOV,    "1011wrrr", NO_REG, 0, 0,       OPCODE_REG,  IMM),
+    SPEC(MOV,    "1010000w", NO_REG, 0, 0,       ACC,         ADDR),
+    SPEC(MOV,    "1010001w", NO_REG, 0, 0,       ADDR,        ACC),
+    SPEC(MOV,    "100011d0", NO_REG, 1, 0,       SREG,        RM),
+    SPEC(PUSH,   "11111111", 6,      1, 0,       RM,          NONE),
+    SPEC(PUSH,   "01010rrr", NO_REG, 1, 0,       OPCODE_REG,  NONE),
+    SPEC(PUSH,   "000gg110", NO_REG, 1, 0,       OPCODE_SREG, NONE),
+    SPEC(POP,    "10001111", 0,      1, 0,       RM,          NONE),
+    SPEC(POP,    "01011rrr", NO_REG, 1, 0,       OPCODE_REG,  NONE),
+    SPEC(POP,    "000gg111", NO_REG, 1, 0,       OPCODE_SREG, NONE),
+    SPEC(XCHG,   "1000011w", NO_REG, 0, 0,       REG,         RM),
+    SPEC(XCHG,   "10010rrr", NO_REG, 1, 0,       ACC,         OPCODE_REG),
+    SPEC(IN,     "1110010w", NO_REG, 0, 0,       ACC,         IMM8),
+    SPEC(IN,     "1110110w", NO_REG, 0, 0,       ACC,         DX),
+    SPEC(OUT,    "1110011w", NO_REG, 0, 0,       IMM8,        ACC),
+    SPEC(OUT,    "1110111w", NO_REG, 0, 0,       DX,          ACC),
+    SPEC(XLAT,   "11010111", NO_REG, 0, 0,       NONE,        NONE),
+    SPEC(LEA,    "10001101", NO_REG, 1, 0,       REG,         RM),
+    SPEC(LDS,    "11000101", NO_REG, 1, 0,       REG,         RM),
+    SPEC(LES,    "11000100", NO_REG, 1, 0,       REG,         RM),
+    SPEC(LAHF,   "10011111", NO_REG, 0, 0,       NONE,        NONE),
+    SPEC(SAHF,   "10011110", NO_REG, 0, 0,       NONE,        NONE),
+    SPEC(PUSHF,  "10011100", NO_REG, 0, 0,       NONE,        NONE),
+    SPEC(POPF,   "10011101", NO_REG, 0, 0,       NONE,        NONE),
+
+    /* Arithmetic */
+    SPEC(ADD,    "000000dw", NO_REG, 0, 0,       REG,         RM),
+    SPEC(ADD,    "100000sw", 0,      0, 0,       RM,          IMM),
+    SPEC(ADD,    "0000010w", NO_REG, 0, 0,       ACC,         IMM),
+    SPEC(ADC,    "000100dw", NO_REG, 0, 0,       REG,         RM),
+    SPEC(ADC,    "100000sw", 2,      0, 0,       RM,          IMM),
+    SPEC(ADC,    "0001010w", NO_REG, 0, 0,       ACC,         IMM),
+    SPEC(INC,    "1111111w", 0,      0, 0,       RM,          NONE),
+    SPEC(INC,    "01000rrr", NO_REG, 1, 0,       OPCODE_REG,  NONE),
+    SPEC(AAA,    "00110111", NO_REG, 0, 0,       NONE,        NONE),
+    SPEC(DAA,    "00100111", NO_REG, 0, 0,       NONE,        NONE),
+    SPEC(SUB,    "001010dw", NO_REG, 0, 0,       REG,         RM),
+    SPEC(SUB,    "100000sw", 5,      0, 0,       RM,          IMM),
+    SPEC(SUB,    "0010110w", NO_REG, 0, 0,       ACC,         IMM),
+    SPEC(SBB,    "000110dw", NO_REG, 0, 0,       REG,         RM),
+    SPEC(SBB,    "100000sw", 3,      0, 0,       RM,          IMM),
+    SPEC(SBB,    "0001110w", NO_REG, 0, 0,       ACC,         IMM),
+    SPEC(DEC,    "1111111w", 1,      0, 0,       RM,          NONE),
+    SPEC(DEC,    "01001rrr", NO_REG, 1, 0,       OPCODE_REG,  NONE),
+    SPEC(NEG,    "1111011w", 3,      0, 0,       RM,          NONE),
+    SPEC(CMP,    "001110dw", NO_REG, 0, 0,       REG,         RM),
+    SPEC(CMP,    "100000sw", 7,      0, 0,       RM,          IMM),
+    SPEC(CMP,    "0011110w", NO_REG, 0, 0,       ACC,         IMM),
+    SPEC(AAS,    "00111111", NO_REG, 0, 0,       NONE,        NONE),
+    SPEC(DAS,    "00101111", NO_REG, 0, 0,       NONE,        NONE),
+    SPEC(MUL,    "1111011w", 4,      0, 0,       RM,          NONE),
+    SPEC(IMUL,   "1111011w", 5,      0, 0,       RM,          NONE),
+    SPEC(AAM,    "11010100", NO_REG, 0, 0,       BASE,        NONE),
+    SPEC(DIV,    "1111011w", 6,      0, 0,       RM,          NONE),
+    SPEC(IDIV,   "1111011w", 7,      0, 0,       RM,          NONE),
+    SPEC(AAD,    "11010101", NO_REG, 0, 0,       BASE,        NONE),
+    SPEC(CBW,    "10011000", NO_REG, 0, 0,       NONE,        NONE),
+    SPEC(CWD,    "10011001", NO_REG, 0, 0,       NONE,        NONE),
+
+    /* Logic */
+    SPEC(NOT,    "1111011w", 2,      0, 0,       RM,          NONE),
+    SPEC(ROL,    "110100vw", 0,      0, 0,       RM,          SHIFT_COUNT),
+    SPEC(ROR,    "110100vw", 1,      0, 0,       RM,          SHIFT_COUNT),
+    SPEC(RCL,    "110100vw", 2,      0, 0,       RM,          SHIFT_COUNT),
+    SPEC(RCR,    "110100vw", 3,      0, 0,       RM,          SHIFT_COUNT),
+    SPEC(SHL,    "110100vw", 4,      0, 0,       RM,          SHIFT_COUNT),
+    SPEC(SHR,    "110100vw", 5,      0, 0,       RM,          SHIFT_COUNT),
+    SPEC(SAR,    "110100vw", 7,      0, 0,       RM,          SHIFT_COUNT),
+    SPEC(AND,    "001000dw", NO_REG, 0, 0,       REG,         RM),
+    SPEC(AND,    "100000sw", 4,      0, 0,       RM,          IMM),
+    SPEC(AND,    "0010010w", NO_REG, 0, 0,       ACC,         IMM),
+    SPEC(TEST,   "1000010w", NO_REG, 0, 0,       RM,          REG),
+    SPEC(TEST,   "1111011w", 0,      0, 0,       RM,          IMM),
+    SPEC(TEST,   "1010100w", NO_REG, 0, 0,       ACC,         IMM),
+    SPEC(OR,     "000010dw", NO_REG, 0, 0,       REG,         RM),
+    SPEC(OR,     "100000sw", 1,      0, 0,       RM,          IMM),
+    SPEC(OR,     "0000110w", NO_REG, 0, 0,       ACC,         IMM),
+    SPEC(XOR,    "001100dw", NO_REG, 0, 0,       REG,         RM),
+    SPEC(XOR,    "100000sw", 6,      0, 0,       RM,          IMM),
+    SPEC(XOR,    "0011010w", NO_REG, 0, 0,       ACC,         IMM),
+
+    /* String manipulation */
+    SPEC(REP,    "1111001z", NO_REG, 0, PREFIX,  NONE,        NONE),
+    SPEC(MOVS,   "1010010w", NO_REG, 0, SUFFIX,  NONE,        NONE),
+    SPEC(CMPS,   "1010011w", NO_REG, 0, SUFFIX,  NONE,        NONE),
+    SPEC(SCAS,   "1010111w", NO_REG, 0, SUFFIX,  NONE,        NONE),
+    SPEC(LODS,   "1010110w", NO_REG, 0, SUFFIX,  NONE,        NONE),
+    SPEC(STOS,   "1010101w", NO_REG, 0, SUFFIX,  NONE,        NONE),
+
+    /* Control transfer */
+    SPEC(CALL,   "11101000", NO_REG, 1, 0,       REL16,       NONE),
+    SPEC(CALL,   "11111111", 2,      1, 0,       RM,          NONE),
+    SPEC(CALL,   "10011010", NO_REG, 1, 0,       FAR_POINTER, NONE),
+    SPEC(CALL,   "11111111", 3,      1, FAR,     RM,          NONE),
+    SPEC(JMP,    "11101001", NO_REG, 1, 0,       REL16,       NONE),
+    SPEC(JMP,    "11101011", NO_REG, 0, 0,       REL8,        NONE),
+    SPEC(JMP,    "11111111", 4,      1, 0,       RM,          NONE),
+    SPEC(JMP,    "11101010", NO_REG, 1, 0,       FAR_POINTER, NONE),
+    SPEC(JMP,    "11111111", 5,      1, FAR,     RM,          NONE),
+    SPEC(RET,    "11000011", NO_REG, 0, 0,       NONE,        NONE),
+    SPEC(RET,    "11000010", NO_REG, 1, 0,       IMM16,       NONE),
+    SPEC(RETF,   "11001011", NO_REG, 0, 0,       NONE,        NONE),
+    SPEC(RETF,   "11001010", NO_REG, 1, 0,       IMM16,       NONE),
+    SPEC(JO,     "01110000", NO_REG, 0, 0,       REL8,        NONE),
+    SPEC(JNO,    "01110001", NO_REG, 0, 0,       REL8,        NONE),
+    SPEC(JB,     "01110010", NO_REG, 0, 0,       REL8,        NONE),
+    SPEC(JNB,    "01110011", NO_REG, 0, 0,       REL8,        NONE),
+    SPEC(JE,     "01110100", NO_REG, 0, 0,       REL8,        NONE),
+    SPEC(JNE,    "01110101", NO_REG, 0, 0,       REL8,        NONE),
+    SPEC(JBE,    "01110110", NO_REG, 0, 0,       REL8,        NONE),
+    SPEC(JA,     "01110111", NO_REG, 0, 0,       REL8,        NONE),
+    SPEC(JS,     "01111000", NO_REG, 0, 0,       REL8,        NONE),
+    SPEC(JNS,    "01111001", NO_REG, 0, 0,       REL8,        NONE),
+    SPEC(JP,     "01111010", NO_REG, 0, 0,       REL8,        NONE),
+    SPEC(JNP,    "01111011", NO_REG, 0, 0,       REL8,        NONE),
+    SPEC(JL,     "01111100", NO_REG, 0, 0,       REL8,        NONE),
+    SPEC(JNL,    "01111101", NO_REG, 0, 0,       REL8,        NONE),
+    SPEC(JLE,    "01111110", NO_REG, 0, 0,       REL8,        NONE),
+    SPEC(JG,     "01111111", NO_REG, 0, 0,       REL8,        NONE),
+    SPEC(LOOPNZ, "11100000", NO_REG, 0, 0,       REL8,        NONE),
+    SPEC(LOOPZ,  "11100001", NO_REG, 0, 0,       REL8,        NONE),
+    SPEC(LOOP,   "11100010", NO_REG, 0, 0,       REL8,        NONE),
+    SPEC(JCXZ,   "11100011", NO_REG, 0, 0,       REL8,        NONE),
+    SPEC(INT,    "11001101", NO_REG, 0, 0,       IMM8,        NONE),
+    SPEC(INT3,   "11001100", NO_REG, 0, 0,       NONE,        NONE),
+    SPEC(INTO,   "11001110", NO_REG, 0, 0,       NONE,        NONE),
+    SPEC(IRET,   "11001111", NO_REG, 0, 0,       NONE,        NONE),
+
+    /* Processor control */
+    SPEC(CLC,    "11111000", NO_REG, 0, 0,       NONE,        NONE),
+    SPEC(CMC,    "11110101", NO_REG, 0, 0,       NONE,        NONE),
+    SPEC(STC,    "11111001", NO_REG, 0, 0,       NONE,        NONE),
+    SPEC(CLD,    "11111100", NO_REG, 0, 0,       NONE,        NONE),
+    SPEC(STD,    "11111101", NO_REG, 0, 0,       NONE,        NONE),
+    SPEC(CLI,    "11111010", NO_REG, 0, 0,       NONE,        NONE),
+    SPEC(STI,    "11111011", NO_REG, 0, 0,       NONE,        NONE),
+    SPEC(HLT,    "11110100", NO_REG, 0, 0,       NONE,        NONE),
+    SPEC(WAIT,   "10011011", NO_REG, 0, 0,       NONE,        NONE),
+    SPEC(ESC,    "11011rrr", NO_REG, 0, NO_SIZE, ESC,         RM),
+    SPEC(LOCK,   "11110000", NO_REG, 0, PREFIX,  NONE,        NONE),
+    SPEC(SEGMENT,"001gg110", NO_REG, 0, PREFIX,  NONE,        NONE),
+};
+
+const uint32_t instruction_spec_count = sizeof(instruction_specs) / sizeof(instruction_spec_t);
@@ -0,0 +1,91 @@
+/*
+Copyright (c) 2023 Daniel Fedai Larsen
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef DECODER_TABLE_H
+#define DECODER_TABLE_H
+
+#include "instruction.h"
+
+#include <stdint.h>
+
+/* The instruction isn't selected by the REG field of the ModR/M byte */
+#define SPEC_NO_REG -1
+
+/* Memory operand is a far (segment:offset) pointer */
+#define SPEC_FLAG_FAR          (uint8_t)(1U << 0)
+/* Operand size is written as a 'b'/'w' suffix on the mnemonic */
+#define SPEC_FLAG_WIDTH_SUFFIX (uint8_t)(1U << 1)
+/* Memory operand has no size, it's never spelled out */
+#define SPEC_FLAG_NO_SIZE      (uint8_t)(1U << 2)
+/* Byte is a prefix to the next instruction */
+#define SPEC_FLAG_PREFIX       (uint8_t)(1U << 3)
+
+/**
+ * Where an operand comes from. Operands are listed as they are with D=1, i.e. REG is the destination, and are swapped
+ * when the opcode has a D bit that is 0.
+*/
+typedef enum
+{
+    OPERAND_TEMPLATE_NONE = 0,
+    OPERAND_TEMPLATE_RM,          /* Register or memory from MOD and R/M */
+    OPERAND_TEMPLATE_REG,         /* Register from REG */
+    OPERAND_TEMPLATE_SREG,        /* Segment register from REG */
+    OPERAND_TEMPLATE_OPCODE_REG,  /* Register from the 'r' bits of the opcode */
+    OPERAND_TEMPLATE_OPCODE_SREG, /* Segment register from the 'g' bits of the opcode */
+    OPERAND_TEMPLATE_ACC,         /* AL or AX */
+    OPERAND_TEMPLATE_DX,          /* DX, port number of 'in' and 'out' */
+    OPERAND_TEMPLATE_SHIFT_COUNT, /* CL if V=1, 1 if V=0 */
+    OPERAND_TEMPLATE_IMM,         /* 8- or 16-bit immediate depending on W and S */
+    OPERAND_TEMPLATE_IMM8,        /* 8-bit immediate */
+    OPERAND_TEMPLATE_IMM16,       /* 16-bit immediate */
+    OPERAND_TEMPLATE_BASE,        /* 8-bit base of 'aam' and 'aad', left out when it's 10 */
+    OPERAND_TEMPLATE_ESC,         /* 6-bit external opcode from the 'r' bits of the opcode and REG */
+    OPERAND_TEMPLATE_ADDR,        /* Direct 16-bit address */
+    OPERAND_TEMPLATE_REL8,        /* 8-bit jump displacement */
+    OPERAND_TEMPLATE_REL16,       /* 16-bit jump displacement */
+    OPERAND_TEMPLATE_FAR_POINTER, /* 16-bit offset followed by a 16-bit segment */
+    OPERAND_TEMPLATE_COUNT
+} operand_template_t;
+
+/**
+ * One encoding of an instruction.
+ *
+ * The pattern gives the bits of the first byte from the most to the least significant bit. '0' and '1' must match, the
+ * letters name the fields: 'd', 'w', 's', 'v' and 'z' (see the comment on 'decoder_decode_stream'), 'r' for a register
+ * and 'g' for a segment register encoded in the opcode.
+*/
+typedef struct
+{
+    uint8_t operation;                              /* operation_t */
+    const char* pattern;                            /* Bits of the first byte */
+    int8_t reg;                                     /* Value of the REG field selecting this instruction, or SPEC_NO_REG */
+    uint8_t w;                                      /* Operand size when the pattern has no W bit */
+    uint8_t flags;                                  /* SPEC_FLAG_* */
+    uint8_t operands[INSTRUCTION_OPERAND_COUNT];    /* operand_template_t of the destination and the source */
+} instruction_spec_t;
+
+/* Every encoding of the 8086 instruction set */
+extern const instruction_spec_t instruction_specs[];
+extern const uint32_t instruction_spec_count;
+
+#endif
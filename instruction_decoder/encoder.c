@@ -0,0 +1,506 @@
+/*
+Copyright (c) 2023 Daniel Fedai Larsen
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "encoder.h"
+
+#include "decoder.h"
+#include "decoder_table.h"
+
+#include <string.h>
+
+/* Room for every entry in 'instruction_specs' */
+#define ENCODER_MAX_SPEC_COUNT 256U
+/* Most encodings a single operation has */
+#define ENCODER_MAX_CANDIDATE_COUNT 8U
+/* Position of a field the pattern doesn't have */
+#define FIELD_NONE 0xFF
+
+/**
+ * Pattern of a spec turned around for encoding: the fixed bits of the first byte and where its fields go.
+*/
+typedef struct
+{
+    uint8_t opcode;    /* Fixed bits of the first byte, fields cleared */
+    uint8_t d_shift;   /* Bit position of D, FIELD_NONE if the pattern has none */
+    uint8_t w_shift;   /* Bit position of W */
+    uint8_t s_shift;   /* Bit position of S */
+    uint8_t vz_shift;  /* Bit position of V or Z */
+    uint8_t reg_shift; /* Bit position of the lowest register or segment register bit */
+    uint8_t has_modrm; /* A ModR/M byte follows the opcode */
+} encoder_layout_t;
+
+/**
+ * Every spec that encodes an operation, in table order.
+*/
+typedef struct
+{
+    uint8_t count;
+    uint8_t specs[ENCODER_MAX_CANDIDATE_COUNT];
+} encoder_candidates_t;
+
+/**
+ * An encoding being put together. Relative targets are resolved last, they depend on the length of the encoding.
+*/
+typedef struct
+{
+    uint8_t opcode;
+    uint8_t modrm;
+    uint8_t displacement_size;
+    uint8_t immediate_size;
+    uint8_t displacement[2];
+    uint8_t immediate[4];
+    uint8_t relative_size;   /* 1 or 2 for a relative operand, 0 otherwise */
+    int32_t relative_target; /* Jump target relative to the start of the instruction */
+} encoding_t;
+
+static encoder_layout_t encoder_layouts[ENCODER_MAX_SPEC_COUNT];
+static encoder_candidates_t encoder_candidates[OPERATION_COUNT];
+static bool encoder_initialized = false;
+
+static void encoder_init_layout(const instruction_spec_t* const spec, encoder_layout_t* const layout)
+{
+    memset(layout, FIELD_NONE, sizeof(encoder_layout_t));
+    layout->opcode = 0;
+    for (uint8_t i = 0; i < 8; i++)
+    {
+        const uint8_t shift = 7 - i;
+        switch (spec->pattern[i])
+        {
+            case '1':
+            {
+                layout->opcode |= (uint8_t)(1U << shift);
+                break;
+            }
+            case '0':
+            {
+                break;
+            }
+            case 'd':
+            {
+                layout->d_shift = shift;
+                break;
+            }
+            case 'w':
+            {
+                layout->w_shift = shift;
+                break;
+            }
+            case 's':
+            {
+                layout->s_shift = shift;
+                break;
+            }
+            case 'v':
+            case 'z':
+            {
+                layout->vz_shift = shift;
+                break;
+            }
+            default: /* 'r' or 'g', the last one seen is the lowest */
+            {
+                layout->reg_shift = shift;
+                break;
+            }
+        }
+    }
+
+    layout->has_modrm = (spec->reg != SPEC_NO_REG);
+    for (uint32_t i = 0; i < INSTRUCTION_OPERAND_COUNT; i++)
+    {
+        const uint8_t operand = spec->operands[i];
+        if ((operand == OPERAND_TEMPLATE_RM) || (operand == OPERAND_TEMPLATE_REG) || (operand == OPERAND_TEMPLATE_SREG) || (operand == OPERAND_TEMPLATE_ESC))
+        {
+            layout->has_modrm = true;
+        }
+    }
+}
+
+void encoder_init(void)
+{
+    if (encoder_initialized == true)
+    {
+        return;
+    }
+
+    memset(encoder_candidates, 0, sizeof(encoder_candidates));
+    for (uint32_t i = 0; i < instruction_spec_count; i++)
+    {
+        const instruction_spec_t* const spec = &instruction_specs[i];
+        encoder_init_layout(spec, &encoder_layouts[i]);
+        if ((spec->flags & SPEC_FLAG_PREFIX) == 0)
+        {
+            encoder_candidates_t* const candidates = &encoder_candidates[spec->operation];
+            candidates->specs[candidates->count] = (uint8_t)i;
+            candidates->count++;
+        }
+    }
+
+    encoder_initialized = true;
+}
+
+static bool encoder_is_general_register(const operand_t* const operand, const uint8_t w)
+{
+    return (operand->kind == OPERAND_REGISTER) && (operand->value < REGISTER_ES) && ((operand->value >> 3) == w);
+}
+
+static bool encoder_is_segment_register(const operand_t* const operand)
+{
+    return (operand->kind == OPERAND_REGISTER) && (operand->value >= REGISTER_ES) && (operand->value <= REGISTER_DS);
+}
+
+static void encoder_set_word(uint8_t* const bytes, const uint16_t value)
+{
+    bytes[0] = (uint8_t)(value & 0xFF);
+    bytes[1] = (uint8_t)(value >> 8);
+}
+
+/**
+ * Encode a memory operand in MOD, R/M and the displacement, with the shortest displacement NASM would pick.
+*/
+static void encoder_encode_memory(const instruction_t* const inst, const operand_t* const operand, encoding_t* const encoding)
+{
+    if (operand->value == EFFECTIVE_ADDRESS_DIRECT)
+    {
+        encoding->modrm |= 0b00000110;
+        encoding->displacement_size = 2;
+        encoder_set_word(encoding->displacement, inst->displacement);
+        return;
+    }
+
+    const int16_t displacement = (inst->flags & INSTRUCTION_FLAG_HAS_DISPLACEMENT) ? (int16_t)inst->displacement : 0;
+    encoding->modrm |= operand->value;
+    /* [bp] has no MOD=00 form, R/M=110 means a direct address there */
+    if ((displacement == 0) && (operand->value != EFFECTIVE_ADDRESS_BP))
+    {
+        return;
+    }
+    if ((displacement >= INT8_MIN) && (displacement <= INT8_MAX))
+    {
+        encoding->modrm |= 0b01000000;
+        encoding->displacement_size = 1;
+        encoding->displacement[0] = (uint8_t)displacement;
+    }
+    else /* 16-bit displacement */
+    {
+        encoding->modrm |= 0b10000000;
+        encoding->displacement_size = 2;
+        encoder_set_word(encoding->displacement, (uint16_t)displacement);
+    }
+}
+
+/**
+ * Check that an operand fits a template and put it in the encoding.
+*/
+static bool encoder_encode_operand(const instruction_t* const inst, const operand_t* const operand, const uint8_t operand_template, const encoder_layout_t* const layout, const uint8_t w, encoding_t* const encoding)
+{
+    switch (operand_template)
+    {
+        case OPERAND_TEMPLATE_NONE:
+        {
+            return operand->kind == OPERAND_NONE;
+        }
+        case OPERAND_TEMPLATE_RM:
+        {
+            if (encoder_is_general_register(operand, w) == true)
+            {
+                encoding->modrm |= 0b11000000 | (operand->value & 0b111);
+                return true;
+            }
+            if (operand->kind == OPERAND_MEMORY)
+            {
+                encoder_encode_memory(inst, operand, encoding);
+                return true;
+            }
+            return false;
+        }
+        case OPERAND_TEMPLATE_REG:
+        {
+            if (encoder_is_general_register(operand, w) == false)
+            {
+                return false;
+            }
+            encoding->modrm |= (operand->value & 0b111) << 3;
+            return true;
+        }
+        case OPERAND_TEMPLATE_SREG:
+        {
+            if (encoder_is_segment_register(operand) == false)
+            {
+                return false;
+            }
+            encoding->modrm |= (operand->value - REGISTER_ES) << 3;
+            return true;
+        }
+        case OPERAND_TEMPLATE_OPCODE_REG:
+        {
+            if (encoder_is_general_register(operand, w) == false)
+            {
+                return false;
+            }
+            encoding->opcode |= (operand->value & 0b111) << layout->reg_shift;
+            return true;
+        }
+        case OPERAND_TEMPLATE_OPCODE_SREG:
+        {
+            if (encoder_is_segment_register(operand) == false)
+            {
+                return false;
+            }
+            encoding->opcode |= (operand->value - REGISTER_ES) << layout->reg_shift;
+            return true;
+        }
+        case OPERAND_TEMPLATE_ACC:
+        {
+            return (operand->kind == OPERAND_REGISTER) && (operand->value == (w << 3));
+        }
+        case OPERAND_TEMPLATE_DX:
+        {
+            return (operand->kind == OPERAND_REGISTER) && (operand->value == REGISTER_DX);
+        }
+        case OPERAND_TEMPLATE_SHIFT_COUNT:
+        {
+            if ((operand->kind == OPERAND_REGISTER) && (operand->value == REGISTER_CL))
+            {
+                encoding->opcode |= 1U << layout->vz_shift;
+                return true;
+            }
+            return (operand->kind == OPERAND_IMMEDIATE) && (inst->immediate == 1);
+        }
+        case OPERAND_TEMPLATE_IMM:
+        {
+            if (operand->kind != OPERAND_IMMEDIATE)
+            {
+                return false;
+            }
+            /* Word immediates that fit in a signed byte are sign-extended when the opcode allows it */
+            const int16_t immediate = (int16_t)inst->immediate;
+            if ((layout->s_shift != FIELD_NONE) && (w == 1) && (immediate >= INT8_MIN) && (immediate <= INT8_MAX))
+            {
+                encoding->opcode |= 1U << layout->s_shift;
+                encoding->immediate_size = 1;
+            }
+            else /* Full size immediate */
+            {
+                encoding->immediate_size = (w == 1) ? 2 : 1;
+            }
+            encoder_set_word(encoding->immediate, inst->immediate);
+            return true;
+        }
+        case OPERAND_TEMPLATE_IMM8:
+        {
+            encoding->immediate_size = 1;
+            encoding->immediate[0] = (uint8_t)inst->immediate;
+            return (operand->kind == OPERAND_IMMEDIATE) && (inst->immediate <= UINT8_MAX);
+        }
+        case OPERAND_TEMPLATE_IMM16:
+        {
+            encoding->immediate_size = 2;
+            encoder_set_word(encoding->immediate, inst->immediate);
+            return operand->kind == OPERAND_IMMEDIATE;
+        }
+        case OPERAND_TEMPLATE_BASE:
+        {
+            /* No operand means base 10 */
+            encoding->immediate_size = 1;
+            encoding->immediate[0] = (operand->kind == OPERAND_NONE) ? 10 : (uint8_t)inst->immediate;
+            return (operand->kind == OPERAND_NONE) || ((operand->kind == OPERAND_IMMEDIATE) && (inst->immediate <= UINT8_MAX));
+        }
+        case OPERAND_TEMPLATE_ESC:
+        {
+            if ((operand->kind != OPERAND_IMMEDIATE) || (inst->immediate >= 64))
+            {
+                return false;
+            }
+            encoding->opcode |= (inst->immediate >> 3) << layout->reg_shift;
+            encoding->modrm |= (inst->immediate & 0b111) << 3;
+            return true;
+        }
+        case OPERAND_TEMPLATE_ADDR:
+        {
+            if ((operand->kind != OPERAND_MEMORY) || (operand->value != EFFECTIVE_ADDRESS_DIRECT))
+            {
+                return false;
+            }
+            encoding->displacement_size = 2;
+            encoder_set_word(encoding->displacement, inst->displacement);
+            return true;
+        }
+        case OPERAND_TEMPLATE_REL8:
+        case OPERAND_TEMPLATE_REL16:
+        {
+            encoding->relative_size = (operand_template == OPERAND_TEMPLATE_REL16) ? 2 : 1;
+            encoding->relative_target = (int32_t)(int16_t)inst->immediate + inst->length;
+            return operand->kind == OPERAND_RELATIVE;
+        }
+        default: /* OPERAND_TEMPLATE_FAR_POINTER */
+        {
+            encoding->immediate_size = 4;
+            encoder_set_word(encoding->immediate, inst->displacement);
+            encoder_set_word(encoding->immediate + 2, inst->immediate);
+            return operand->kind == OPERAND_FAR_POINTER;
+        }
+    }
+}
+
+/**
+ * Encode an instruction with one spec and direction. Returns the length, or 0 if the spec can't encode it.
+*/
+static uint32_t encoder_encode_spec(const instruction_t* const inst, const instruction_spec_t* const spec, const encoder_layout_t* const layout, const uint8_t d, const uint32_t prefix_count, encoding_t* const encoding)
+{
+    if (((spec->flags & SPEC_FLAG_FAR) != 0) != ((inst->flags & INSTRUCTION_FLAG_FAR) != 0))
+    {
+        return 0;
+    }
+
+    memset(encoding, 0, sizeof(encoding_t));
+    encoding->opcode = layout->opcode;
+    uint8_t w = spec->w;
+    if (layout->w_shift != FIELD_NONE)
+    {
+        w = inst->w;
+        encoding->opcode |= w << layout->w_shift;
+    }
+    if (layout->d_shift != FIELD_NONE)
+    {
+        encoding->opcode |= d << layout->d_shift;
+    }
+    if (spec->reg != SPEC_NO_REG)
+    {
+        encoding->modrm |= (uint8_t)spec->reg << 3;
+    }
+
+    /* Operands are listed with REG as the destination, D=0 swaps them */
+    for (uint32_t i = 0; i < INSTRUCTION_OPERAND_COUNT; i++)
+    {
+        const uint8_t operand_template = spec->operands[(d == 1) ? i : (INSTRUCTION_OPERAND_COUNT - 1 - i)];
+        if (encoder_encode_operand(inst, &inst->operands[i], operand_template, layout, w, encoding) == false)
+        {
+            return 0;
+        }
+    }
+
+    const uint32_t length = prefix_count + 1 + layout->has_modrm + encoding->displacement_size + encoding->immediate_size + encoding->relative_size;
+    if (encoding->relative_size > 0)
+    {
+        const int32_t relative = encoding->relative_target - (int32_t)length;
+        if ((encoding->relative_size == 1) && ((relative < INT8_MIN) || (relative > INT8_MAX)))
+        {
+            return 0;
+        }
+        encoding->immediate_size = encoding->relative_size;
+        encoder_set_word(encoding->immediate, (uint16_t)relative);
+    }
+
+    return length;
+}
+
+uint32_t encoder_encode_one(const instruction_t* const inst, uint8_t* const output)
+{
+    encoder_init();
+    if (inst->operation >= OPERATION_COUNT)
+    {
+        return 0;
+    }
+
+    /* NASM writes LOCK and REP before the segment override */
+    uint8_t prefixes[INSTRUCTION_MAX_PREFIX_COUNT];
+    uint32_t prefix_count = 0;
+    if (inst->flags & INSTRUCTION_FLAG_LOCK)
+    {
+        prefixes[prefix_count++] = 0xF0;
+    }
+    if (inst->flags & INSTRUCTION_FLAG_REP)
+    {
+        prefixes[prefix_count++] = 0xF3;
+    }
+    else if (inst->flags & INSTRUCTION_FLAG_REPNE)
+    {
+        prefixes[prefix_count++] = 0xF2;
+    }
+    if (inst->flags & INSTRUCTION_FLAG_SEGMENT_OVERRIDE)
+    {
+        prefixes[prefix_count++] = 0x26 | (uint8_t)((inst->segment - REGISTER_ES) << 3);
+    }
+
+    /* Shortest encoding wins, ties go to the first spec and to D=0 like in NASM */
+    const encoder_candidates_t* const candidates = &encoder_candidates[inst->operation];
+    const encoder_layout_t* best_layout = NULL;
+    encoding_t best;
+    uint32_t best_length = 0;
+    for (uint32_t i = 0; i < candidates->count; i++)
+    {
+        const instruction_spec_t* const spec = &instruction_specs[candidates->specs[i]];
+        const encoder_layout_t* const layout = &encoder_layouts[candidates->specs[i]];
+        const uint8_t first_d = (layout->d_shift != FIELD_NONE) ? 0 : 1;
+        for (uint8_t d = first_d; d <= 1; d++)
+        {
+            encoding_t encoding;
+            const uint32_t length = encoder_encode_spec(inst, spec, layout, d, prefix_count, &encoding);
+            if ((length > 0) && ((best_length == 0) || (length < best_length)))
+            {
+                best = encoding;
+                best_layout = layout;
+                best_length = length;
+            }
+        }
+    }
+    if (best_length == 0)
+    {
+        return 0;
+    }
+
+    uint32_t index = 0;
+    memcpy(output, prefixes, prefix_count);
+    index += prefix_count;
+    output[index++] = best.opcode;
+    if (best_layout->has_modrm == true)
+    {
+        output[index++] = best.modrm;
+    }
+    memcpy(output + index, best.displacement, best.displacement_size);
+    index += best.displacement_size;
+    memcpy(output + index, best.immediate, best.immediate_size);
+    index += best.immediate_size;
+
+    return index;
+}
+
+bool encoder_verify_stream(const uint8_t* const inst_stream, const uint32_t inst_stream_len, uint32_t* const mismatch_offset)
+{
+    instruction_t inst;
+    uint8_t encoded[INSTRUCTION_MAX_LENGTH];
+    uint32_t index = 0;
+    while (index < inst_stream_len)
+    {
+        if ((decoder_decode_one(inst_stream, inst_stream_len, index, &inst) == false) ||
+            (encoder_encode_one(&inst, encoded) != inst.length) ||
+            (memcmp(encoded, inst_stream + index, inst.length) != 0))
+        {
+            *mismatch_offset = index;
+            return false;
+        }
+        index += inst.length;
+    }
+
+    return true;
+}
@@ -0,0 +1,62 @@
+/*
+Copyright (c) 2023 Daniel Fedai Larsen
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef ENCODER_H
+#define ENCODER_H
+
+#include "instruction.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @brief Build the encoder's lookup tables
+ *
+ * Encoding calls this on first use. Call it up front before encoding from several threads at once.
+*/
+void encoder_init(void);
+
+/**
+ * @brief Encode an instruction the way NASM encodes its text
+ *
+ * When several encodings exist NASM's choice is made: the shortest one, the register-to-register forms with D=0, the
+ * sign-extended immediate forms for small word immediates, and short jumps whenever the target is in range.
+ * Relative operands keep their target, which is taken from the instruction's 'immediate' and 'length'.
+ *
+ * @param inst Instruction to encode
+ * @param output Buffer for the encoded bytes, at least INSTRUCTION_MAX_LENGTH long
+ * @return Number of bytes written, 0 if the instruction has no encoding
+*/
+uint32_t encoder_encode_one(const instruction_t* const inst, uint8_t* const output);
+
+/**
+ * @brief Decode a stream and check that encoding every instruction again gives back the same bytes
+ *
+ * @param inst_stream Stream of bytes with encoded instructions
+ * @param inst_stream_len Length of 'inst_stream' in bytes
+ * @param mismatch_offset Offset of the first instruction that couldn't be decoded or was encoded differently
+ * @return true if the whole stream was encoded back to the same bytes
+*/
+bool encoder_verify_stream(const uint8_t* const inst_stream, const uint32_t inst_stream_len, uint32_t* const mismatch_offset);
+
+#endif
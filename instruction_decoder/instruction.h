@@ -0,0 +1,233 @@
+/*
+Copyright (c) 2023 Daniel Fedai Larsen
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef INSTRUCTION_H
+#define INSTRUCTION_H
+
+#include <stdint.h>
+
+#define INSTRUCTION_OPERAND_COUNT 2U
+/* A LOCK, a REP and a segment override prefix */
+#define INSTRUCTION_MAX_PREFIX_COUNT 3U
+/* Prefixes, opcode, ModR/M, two bytes of displacement and two bytes of immediate */
+#define INSTRUCTION_MAX_LENGTH (6U + INSTRUCTION_MAX_PREFIX_COUNT)
+
+typedef enum
+{
+    OPERATION_NONE = 0,
+    OPERATION_MOV,
+    OPERATION_PUSH,
+    OPERATION_POP,
+    OPERATION_XCHG,
+    OPERATION_IN,
+    OPERATION_OUT,
+    OPERATION_XLAT,
+    OPERATION_LEA,
+    OPERATION_LDS,
+    OPERATION_LES,
+    OPERATION_LAHF,
+    OPERATION_SAHF,
+    OPERATION_PUSHF,
+    OPERATION_POPF,
+    OPERATION_ADD,
+    OPERATION_ADC,
+    OPERATION_INC,
+    OPERATION_AAA,
+    OPERATION_DAA,
+    OPERATION_SUB,
+    OPERATION_SBB,
+    OPERATION_DEC,
+    OPERATION_NEG,
+    OPERATION_CMP,
+    OPERATION_AAS,
+    OPERATION_DAS,
+    OPERATION_MUL,
+    OPERATION_IMUL,
+    OPERATION_AAM,
+    OPERATION_DIV,
+    OPERATION_IDIV,
+    OPERATION_AAD,
+    OPERATION_CBW,
+    OPERATION_CWD,
+    OPERATION_NOT,
+    OPERATION_SHL,
+    OPERATION_SHR,
+    OPERATION_SAR,
+    OPERATION_ROL,
+    OPERATION_ROR,
+    OPERATION_RCL,
+    OPERATION_RCR,
+    OPERATION_AND,
+    OPERATION_TEST,
+    OPERATION_OR,
+    OPERATION_XOR,
+    OPERATION_MOVS,
+    OPERATION_CMPS,
+    OPERATION_SCAS,
+    OPERATION_LODS,
+    OPERATION_STOS,
+    OPERATION_CALL,
+    OPERATION_JMP,
+    OPERATION_RET,
+    OPERATION_RETF,
+    OPERATION_JE,
+    OPERATION_JL,
+    OPERATION_JLE,
+    OPERATION_JB,
+    OPERATION_JBE,
+    OPERATION_JP,
+    OPERATION_JO,
+    OPERATION_JS,
+    OPERATION_JNE,
+    OPERATION_JNL,
+    OPERATION_JG,
+    OPERATION_JNB,
+    OPERATION_JA,
+    OPERATION_JNP,
+    OPERATION_JNO,
+    OPERATION_JNS,
+    OPERATION_LOOP,
+    OPERATION_LOOPZ,
+    OPERATION_LOOPNZ,
+    OPERATION_JCXZ,
+    OPERATION_INT,
+    OPERATION_INT3,
+    OPERATION_INTO,
+    OPERATION_IRET,
+    OPERATION_CLC,
+    OPERATION_CMC,
+    OPERATION_STC,
+    OPERATION_CLD,
+    OPERATION_STD,
+    OPERATION_CLI,
+    OPERATION_STI,
+    OPERATION_HLT,
+    OPERATION_WAIT,
+    OPERATION_ESC,
+
+    /* Prefixes, they never appear in a decoded instruction */
+    OPERATION_LOCK,
+    OPERATION_REP,
+    OPERATION_SEGMENT,
+
+    OPERATION_COUNT
+} operation_t;
+
+typedef enum
+{
+    OPERAND_NONE = 0,
+    OPERAND_REGISTER,
+    OPERAND_MEMORY,
+    OPERAND_IMMEDIATE,
+    OPERAND_RELATIVE,    /* Jump displacement in 'immediate', relative to the end of the instruction */
+    OPERAND_FAR_POINTER, /* Segment in 'immediate' and offset in 'displacement' */
+} operand_kind_t;
+
+/**
+ * Registers are numbered so that W * 8 + REG gives the register encoded by the REG/R/M fields, and REGISTER_ES + SR
+ * gives the segment register encoded by a 2-bit SR field.
+*/
+typedef enum
+{
+    REGISTER_AL = 0,
+    REGISTER_CL,
+    REGISTER_DL,
+    REGISTER_BL,
+    REGISTER_AH,
+    REGISTER_CH,
+    REGISTER_DH,
+    REGISTER_BH,
+    REGISTER_AX,
+    REGISTER_CX,
+    REGISTER_DX,
+    REGISTER_BX,
+    REGISTER_SP,
+    REGISTER_BP,
+    REGISTER_SI,
+    REGISTER_DI,
+    REGISTER_ES,
+    REGISTER_CS,
+    REGISTER_SS,
+    REGISTER_DS,
+    REGISTER_COUNT
+} register_id_t;
+
+/**
+ * Effective address bases are numbered like the R/M field (see Table 4-10 in the manual). A direct address has no base
+ * and keeps the address in the displacement.
+*/
+typedef enum
+{
+    EFFECTIVE_ADDRESS_BX_SI = 0,
+    EFFECTIVE_ADDRESS_BX_DI,
+    EFFECTIVE_ADDRESS_BP_SI,
+    EFFECTIVE_ADDRESS_BP_DI,
+    EFFECTIVE_ADDRESS_SI,
+    EFFECTIVE_ADDRESS_DI,
+    EFFECTIVE_ADDRESS_BP,
+    EFFECTIVE_ADDRESS_BX,
+    EFFECTIVE_ADDRESS_DIRECT,
+    EFFECTIVE_ADDRESS_COUNT
+} effective_address_t;
+
+/* Memory operand has an 8- or 16-bit displacement (MOD=01 or MOD=10) */
+#define INSTRUCTION_FLAG_HAS_DISPLACEMENT (uint16_t)(1U << 0)
+/* Immediate was sign-extended from 8 to 16 bits */
+#define INSTRUCTION_FLAG_SIGN_EXTENDED    (uint16_t)(1U << 1)
+/* LOCK prefix */
+#define INSTRUCTION_FLAG_LOCK             (uint16_t)(1U << 2)
+/* REP/REPE/REPZ prefix (Z=1) */
+#define INSTRUCTION_FLAG_REP              (uint16_t)(1U << 3)
+/* REPNE/REPNZ prefix (Z=0) */
+#define INSTRUCTION_FLAG_REPNE            (uint16_t)(1U << 4)
+/* Segment override prefix, the segment register is in 'segment' */
+#define INSTRUCTION_FLAG_SEGMENT_OVERRIDE (uint16_t)(1U << 5)
+/* Memory operand holds a far (segment:offset) pointer */
+#define INSTRUCTION_FLAG_FAR              (uint16_t)(1U << 6)
+/* No register operand gives the size of the memory operand, so it must be spelled out */
+#define INSTRUCTION_FLAG_EXPLICIT_SIZE    (uint16_t)(1U << 7)
+/* Operand size is part of the mnemonic, like 'movsb' and 'movsw' */
+#define INSTRUCTION_FLAG_WIDTH_SUFFIX     (uint16_t)(1U << 8)
+
+typedef struct
+{
+    uint8_t kind;  /* operand_kind_t */
+    uint8_t value; /* register_id_t for registers, effective_address_t for memory, unused otherwise */
+} operand_t;
+
+/**
+ * Decoded instruction. The record has a fixed size and holds no pointers, so it can be copied and stored freely.
+*/
+typedef struct
+{
+    uint8_t operation;                              /* operation_t */
+    uint8_t length;                                 /* Encoded length in bytes, prefixes included */
+    uint8_t w;                                      /* 0 = byte data, 1 = word data */
+    uint8_t segment;                                /* register_id_t of the segment override prefix */
+    uint16_t flags;                                 /* INSTRUCTION_FLAG_* */
+    operand_t operands[INSTRUCTION_OPERAND_COUNT];  /* Destination followed by source */
+    uint16_t displacement;                          /* Displacement or direct address of the memory operand */
+    uint16_t immediate;                             /* Value of the immediate or relative operand */
+} instruction_t;
+
+#endif
@@ -0,0 +1,155 @@
+/*
+Copyright (c) 2023 Daniel Fedai Larsen
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "output_buffer.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/* Longest decimal representation of a 32-bit value */
+#define DECIMAL_DIGITS_MAX 10U
+
+char* output_buffer_reserve(output_buffer_t* const buffer, const uint32_t len)
+{
+    if ((buffer->size + len) <= buffer->capacity)
+    {
+        return buffer->data + buffer->size;
+    }
+
+    /* Empty the buffer into the file first, only grow if that isn't enough */
+    output_buffer_flush(buffer);
+    if ((buffer->size + len) <= buffer->capacity)
+    {
+        return buffer->data + buffer->size;
+    }
+
+    uint32_t capacity = buffer->capacity * 2;
+    while (capacity < (buffer->size + len))
+    {
+        capacity *= 2;
+    }
+    buffer->data = realloc(buffer->data, capacity);
+    buffer->capacity = capacity;
+
+    return buffer->data + buffer->size;
+}
+
+void output_buffer_commit(output_buffer_t* const buffer, const char* const end)
+{
+    buffer->size = (uint32_t)(end - buffer->data);
+}
+
+void output_buffer_init(output_buffer_t* const buffer, const uint32_t capacity, FILE* file)
+{
+    buffer->capacity = (capacity > 0) ? capacity : OUTPUT_BUFFER_DEFAULT_CAPACITY;
+    buffer->data = malloc(buffer->capacity);
+    buffer->size = 0;
+    buffer->file = file;
+    buffer->write = NULL;
+    buffer->write_context = NULL;
+}
+
+void output_buffer_init_with_writer(output_buffer_t* const buffer, const uint32_t capacity, const output_buffer_write_t write, void* const write_context)
+{
+    output_buffer_init(buffer, capacity, NULL);
+    buffer->write = write;
+    buffer->write_context = write_context;
+}
+
+void output_buffer_free(output_buffer_t* const buffer)
+{
+    output_buffer_flush(buffer);
+    free(buffer->data);
+    buffer->data = NULL;
+    buffer->size = 0;
+    buffer->capacity = 0;
+}
+
+void output_buffer_flush(output_buffer_t* const buffer)
+{
+    if (buffer->size == 0)
+    {
+        return;
+    }
+
+    if (buffer->write != NULL)
+    {
+        buffer->write(buffer->write_context, buffer->data, buffer->size);
+    }
+    else if (buffer->file != NULL)
+    {
+        fwrite(buffer->data, 1, buffer->size, buffer->file);
+    }
+    else /* In memory */
+    {
+        return;
+    }
+    buffer->size = 0;
+}
+
+void output_buffer_append(output_buffer_t* const buffer, const char* const data, const uint32_t len)
+{
+    output_buffer_reserve(buffer, len);
+    memcpy(buffer->data + buffer->size, data, len);
+    buffer->size += len;
+}
+
+void output_buffer_append_string(output_buffer_t* const buffer, const char* const string)
+{
+    output_buffer_append(buffer, string, (uint32_t)strlen(string));
+}
+
+void output_buffer_append_char(output_buffer_t* const buffer, const char c)
+{
+    output_buffer_reserve(buffer, 1);
+    buffer->data[buffer->size] = c;
+    buffer->size++;
+}
+
+void output_buffer_append_uint(output_buffer_t* const buffer, uint32_t value)
+{
+    /* Produce digits from the back */
+    char digits[DECIMAL_DIGITS_MAX];
+    uint32_t start = DECIMAL_DIGITS_MAX;
+    do
+    {
+        start--;
+        digits[start] = (char)('0' + (value % 10));
+        value /= 10;
+    } while (value != 0);
+
+    output_buffer_append(buffer, &digits[start], DECIMAL_DIGITS_MAX - start);
+}
+
+void output_buffer_append_int(output_buffer_t* const buffer, const int32_t value)
+{
+    if (value < 0)
+    {
+        output_buffer_append_char(buffer, '-');
+        output_buffer_append_uint(buffer, 0U - (uint32_t)value);
+    }
+    else /* value >= 0 */
+    {
+        output_buffer_append_uint(buffer, (uint32_t)value);
+    }
+}
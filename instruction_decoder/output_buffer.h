@@ -0,0 +1,104 @@
+/*
+Copyright (c) 2023 Daniel Fedai Larsen
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef OUTPUT_BUFFER_H
+#define OUTPUT_BUFFER_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+/* Amount of text collected before it's written to the file in one go */
+#define OUTPUT_BUFFER_DEFAULT_CAPACITY (uint32_t)(1U << 20)
+
+/**
+ * Receives the text of a buffer when it's flushed, for writing it somewhere other than a FILE.
+*/
+typedef void (*output_buffer_write_t)(void* const context, const char* const data, const uint32_t len);
+
+/**
+ * Growable text buffer. When a file or writer is attached the buffer is written to it whenever it fills up, otherwise
+ * it keeps growing and the text stays in memory.
+*/
+typedef struct
+{
+    char* data;
+    uint32_t size;
+    uint32_t capacity;
+    FILE* file;
+    output_buffer_write_t write;    /* Used instead of 'file' when set */
+    void* write_context;
+} output_buffer_t;
+
+/**
+ * @brief Allocate an output buffer
+ *
+ * @param buffer Buffer to initialize
+ * @param capacity Initial capacity in bytes
+ * @param file File to flush into, or NULL to keep all text in memory
+*/
+void output_buffer_init(output_buffer_t* const buffer, const uint32_t capacity, FILE* file);
+
+/**
+ * @brief Allocate an output buffer that passes its text to a function when flushed
+ *
+ * @param buffer Buffer to initialize
+ * @param capacity Initial capacity in bytes
+ * @param write Function receiving the text
+ * @param write_context Passed to 'write'
+*/
+void output_buffer_init_with_writer(output_buffer_t* const buffer, const uint32_t capacity, const output_buffer_write_t write, void* const write_context);
+
+/**
+ * @brief Flush remaining text and free the buffer
+*/
+void output_buffer_free(output_buffer_t* const buffer);
+
+/**
+ * @brief Write buffered text to the attached file or writer, does nothing for in-memory buffers
+*/
+void output_buffer_flush(output_buffer_t* const buffer);
+
+/**
+ * @brief Make room for 'len' more bytes and get where to write them, for writing text directly into the buffer
+ *
+ * @param buffer Buffer to write to
+ * @param len Most bytes that will be written
+ * @return Where the next byte goes, pass the end of the written text to 'output_buffer_commit'
+*/
+char* output_buffer_reserve(output_buffer_t* const buffer, const uint32_t len);
+
+/**
+ * @brief Add text written after 'output_buffer_reserve' to the buffer
+ *
+ * @param buffer Buffer written to
+ * @param end Byte after the last one written
+*/
+void output_buffer_commit(output_buffer_t* const buffer, const char* const end);
+
+void output_buffer_append(output_buffer_t* const buffer, const char* const data, const uint32_t len);
+void output_buffer_append_string(output_buffer_t* const buffer, const char* const string);
+void output_buffer_append_char(output_buffer_t* const buffer, const char c);
+void output_buffer_append_uint(output_buffer_t* const buffer, uint32_t value);
+void output_buffer_append_int(output_buffer_t* const buffer, const int32_t value);
+
+#endif
@@ -22,91 +22,653 @@ WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 */
 
 #include "decoder.h"
+#include "decoder_batch.h"
+#include "decoder_binary.h"
+#include "decoder_cache.h"
+#include "decoder_ctx.h"
+#include "decoder_flow.h"
+#include "decoder_format.h"
+#include "decoder_index.h"
+#include "decoder_parallel.h"
+#include "decoder_range.h"
+#include "decoder_stream.h"
+#include "encoder.h"
+#include "file_list.h"
+#include "file_view.h"
+#include "simulator.h"
 
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
-static const char* encoded_assembly_files[] = {
-    // "./test_files/listing_0037_single_register_mov",
-    // "./test_files/listing_0038_many_register_mov",
-    // "./test_files/listing_0039_more_movs",
-    // "./test_files/listing_0040_challenge_movs",
-    "./test_files/listing_0041_add_sub_cmp_jnz",
-    // "./test_files/listing_0042_completionist_decode",
+#if defined(_WIN32)
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+/* Size of each read when decoding from stdin */
+#define STDIN_CHUNK_SIZE (uint32_t)(1U << 16)
+/* Appended to the path of a file to get the path of its saved boundary index */
+#define INDEX_FILE_EXTENSION ".idx"
+/* Programs are stopped after this many instructions so that endless loops end */
+#define EXECUTE_MAX_INST_COUNT (uint64_t)1000000000
+
+/* Verified when no arguments are given */
+#define DEFAULT_BATCH_DIRECTORY "./test_files"
+
+/* Files in a directory with these extensions aren't encoded instructions */
+static const char* batch_skip_extensions[] = {
+    ".asm",
+    INDEX_FILE_EXTENSION,
+    NULL,
 };
 
-int main(int argc, char** argv)
+/**
+ * Decode stdin chunk by chunk and write the result straight to the stdout file descriptor, so input of any size can be
+ * piped through.
+*/
+static int decode_stdin(void)
 {
-    /* Decode all files */
-    const uint8_t encoded_assembly_file_count = sizeof(encoded_assembly_files) / sizeof(char*);
-    for (uint8_t i = 0; i < encoded_assembly_file_count; i++)
-    {
-        /* Print current file */
-        printf("Decoding '%s'\n", encoded_assembly_files[i]);
+#if defined(_WIN32)
+    _setmode(_fileno(stdin), _O_BINARY);
+    _setmode(_fileno(stdout), _O_BINARY);
+    const int stdout_fd = _fileno(stdout);
+#else
+    const int stdout_fd = fileno(stdout);
+#endif
+
+    decoder_sink_t sink;
+    decoder_sink_init_fd(&sink, stdout_fd);
+    decoder_ctx_t* const ctx = decoder_ctx_create(NULL, &sink);
+    decoder_ctx_begin(ctx);
 
-        /* Read file */
-        FILE* file = fopen(encoded_assembly_files[i], "rb");
-        if (file == NULL)
+    static uint8_t chunk[STDIN_CHUNK_SIZE];
+    bool success = true;
+    while (success == true)
+    {
+        const size_t chunk_len = fread(chunk, 1, sizeof(chunk), stdin);
+        if (chunk_len == 0)
         {
-            printf("\t[FILE] Failed to open file '%s'\n", encoded_assembly_files[i]);
-            return -1;
+            break;
         }
-        fseek(file, 0, SEEK_END);
-        uint32_t file_size_original = (uint32_t)ftell(file);
-        fseek(file, 0, SEEK_SET);
-        uint8_t* file_data_original = malloc(file_size_original);
-        fread(file_data_original, file_size_original, 1, file);
-        fclose(file);
-
-        /* Open file to write decoded stream into */
-        file = fopen("tmp.asm", "w");
-        if (file == NULL)
+        success = decoder_ctx_feed(ctx, chunk, (uint32_t)chunk_len);
+    }
+    const bool read_failed = ferror(stdin) != 0;
+    success = (decoder_ctx_finish(ctx) == true) && (success == true);
+    decoder_ctx_destroy(ctx);
+
+    /* After the decoded text, which doesn't go through stdout's buffer */
+    if (read_failed == true)
+    {
+        printf("[FILE] Failed to read stdin\n");
+        success = false;
+    }
+
+    return (success == true) ? 0 : -1;
+}
+
+/**
+ * Decode a file on 'thread_count' threads and write the result to stdout.
+*/
+static int decode_file_parallel(const char* const path, const uint32_t thread_count)
+{
+    file_view_t view;
+    if (file_view_open(&view, path) == false)
+    {
+        printf("[FILE] Failed to open file '%s'\n", path);
+        return -1;
+    }
+    if (view.size > UINT32_MAX)
+    {
+        printf("[FILE] File '%s' is too large (%llu bytes)\n", path, (unsigned long long)view.size);
+        file_view_close(&view);
+        return -1;
+    }
+
+    output_buffer_t buffer;
+    output_buffer_init(&buffer, OUTPUT_BUFFER_DEFAULT_CAPACITY, stdout);
+    decoder_decode_stream_parallel(view.data, (uint32_t)view.size, thread_count, &buffer);
+    output_buffer_free(&buffer);
+
+    file_view_close(&view);
+    return 0;
+}
+
+/**
+ * Decode a file through a cache of decoded instructions and write the result to stdout, and the cache's hit rate to
+ * stderr. The cache only pays off for code that repeats a small set of encodings, it breaks even with plain decoding at
+ * a hit rate of about 60% in the benchmark.
+*/
+static int decode_file_cached(const char* const path, const uint32_t cache_capacity)
+{
+    file_view_t view;
+    if (file_view_open(&view, path) == false)
+    {
+        printf("[FILE] Failed to open file '%s'\n", path);
+        return -1;
+    }
+    if (view.size > UINT32_MAX)
+    {
+        printf("[FILE] File '%s' is too large (%llu bytes)\n", path, (unsigned long long)view.size);
+        file_view_close(&view);
+        return -1;
+    }
+
+    decoder_cache_t cache;
+    decoder_cache_init(&cache, cache_capacity);
+    output_buffer_t buffer;
+    output_buffer_init(&buffer, OUTPUT_BUFFER_DEFAULT_CAPACITY, stdout);
+    decoder_stream_t stream;
+    decoder_stream_init(&stream, &buffer);
+    stream.cache = &cache;
+    decoder_stream_feed(&stream, view.data, (uint32_t)view.size);
+    const bool success = decoder_stream_finish(&stream);
+    output_buffer_free(&buffer);
+
+    output_buffer_t stats;
+    output_buffer_init(&stats, 0, stderr);
+    decoder_cache_format_stats(&cache, &stats);
+    output_buffer_free(&stats);
+
+    decoder_cache_free(&cache);
+    file_view_close(&view);
+    return (success == true) ? 0 : -1;
+}
+
+/**
+ * Decode a file into a binary listing and write it to stdout.
+*/
+static int decode_file_binary(const char* const path)
+{
+#if defined(_WIN32)
+    _setmode(_fileno(stdout), _O_BINARY);
+#endif
+
+    file_view_t view;
+    if (file_view_open(&view, path) == false)
+    {
+        fprintf(stderr, "[FILE] Failed to open file '%s'\n", path);
+        return -1;
+    }
+    if (view.size > UINT32_MAX)
+    {
+        fprintf(stderr, "[FILE] File '%s' is too large (%llu bytes)\n", path, (unsigned long long)view.size);
+        file_view_close(&view);
+        return -1;
+    }
+
+    decoder_binary_t binary;
+    decoder_binary_init(&binary);
+    const bool decoded = decoder_binary_build(&binary, view.data, (uint32_t)view.size);
+    if (decoded == false)
+    {
+        fprintf(stderr, "[DECODE] Decoding stopped at offset %u\n", binary.header.end);
+    }
+    const bool written = decoder_binary_write(&binary, stdout);
+    if (written == false)
+    {
+        fprintf(stderr, "[FILE] Failed to write the binary listing\n");
+    }
+    decoder_binary_free(&binary);
+
+    file_view_close(&view);
+    return ((decoded == true) && (written == true)) ? 0 : -1;
+}
+
+/**
+ * Write a binary listing as assembly text to stdout.
+*/
+static int print_binary_listing(const char* const path)
+{
+    file_view_t view;
+    if (file_view_open(&view, path) == false)
+    {
+        printf("[FILE] Failed to open file '%s'\n", path);
+        return -1;
+    }
+
+    const decoder_binary_header_t* header;
+    const decoder_binary_record_t* const records = decoder_binary_get_records(view.data, view.size, &header);
+    if (records == NULL)
+    {
+        printf("[FILE] '%s' isn't a binary listing of this version\n", path);
+        file_view_close(&view);
+        return -1;
+    }
+
+    output_buffer_t buffer;
+    output_buffer_init(&buffer, OUTPUT_BUFFER_DEFAULT_CAPACITY, stdout);
+    output_buffer_append_string(&buffer, "bits 16\n\n");
+    instruction_t inst;
+    uint32_t i = 0;
+    while ((i < header->record_count) && (decoder_binary_get_instruction(&records[i], &inst) == true))
+    {
+        decoder_format_instruction(&inst, &buffer);
+        i++;
+    }
+    output_buffer_free(&buffer);
+
+    const bool is_valid = i == header->record_count;
+    if (is_valid == false)
+    {
+        printf("[FILE] Record %u in '%s' is invalid\n", i, path);
+    }
+    const bool is_complete = (header->flags & DECODER_BINARY_FLAG_INCOMPLETE) == 0;
+
+    file_view_close(&view);
+    return ((is_valid == true) && (is_complete == true)) ? 0 : -1;
+}
+
+/**
+ * Decode a file in a single pass with labels for jump and call targets, and write the result to stdout.
+*/
+static int decode_file_with_labels(const char* const path)
+{
+    file_view_t view;
+    if (file_view_open(&view, path) == false)
+    {
+        printf("[FILE] Failed to open file '%s'\n", path);
+        return -1;
+    }
+    if (view.size > UINT32_MAX)
+    {
+        printf("[FILE] File '%s' is too large (%llu bytes)\n", path, (unsigned long long)view.size);
+        file_view_close(&view);
+        return -1;
+    }
+
+    decoder_decode_stream_with_labels(view.data, (uint32_t)view.size, stdout);
+
+    file_view_close(&view);
+    return 0;
+}
+
+/**
+ * Disassemble the code reachable from a list of entry points, with labels and basic blocks, and write it to stdout.
+*/
+static int disassemble_file_flow(const char* const path, const char* const* const entry_args, const uint32_t entry_count)
+{
+    file_view_t view;
+    if (file_view_open(&view, path) == false)
+    {
+        printf("[FILE] Failed to open file '%s'\n", path);
+        return -1;
+    }
+    if (view.size > UINT32_MAX)
+    {
+        printf("[FILE] File '%s' is too large (%llu bytes)\n", path, (unsigned long long)view.size);
+        file_view_close(&view);
+        return -1;
+    }
+
+    /* Execution starts at the beginning of the file unless told otherwise */
+    uint32_t default_entry = 0;
+    uint32_t* entries = &default_entry;
+    if (entry_count > 0)
+    {
+        entries = malloc(entry_count * sizeof(uint32_t));
+        for (uint32_t i = 0; i < entry_count; i++)
         {
-            printf("\t[FILE] Failed to open file 'tmp.txt'\n");
-            return -1;
+            entries[i] = (uint32_t)strtoul(entry_args[i], NULL, 0);
         }
+    }
+
+    decoder_flow_t flow;
+    decoder_flow_analyze(&flow, view.data, (uint32_t)view.size, entries, (entry_count > 0) ? entry_count : 1);
+
+    output_buffer_t buffer;
+    output_buffer_init(&buffer, OUTPUT_BUFFER_DEFAULT_CAPACITY, stdout);
+    decoder_flow_format(&flow, &buffer);
+    output_buffer_free(&buffer);
+
+    decoder_flow_free(&flow);
+    if (entries != &default_entry)
+    {
+        free(entries);
+    }
+    file_view_close(&view);
+    return 0;
+}
 
-        /* Decode instructions */
-        decoder_decode_stream(file_data_original, file_size_original, file);
+/**
+ * Execute a file loaded at 0000:0000 until it leaves the program, halts or interrupts, then write the final registers
+ * to stdout.
+*/
+static int execute_file(const char* const path)
+{
+    file_view_t view;
+    if (file_view_open(&view, path) == false)
+    {
+        printf("[FILE] Failed to open file '%s'\n", path);
+        return -1;
+    }
 
-        /* Close file */
-        fclose(file);
+    simulator_t sim;
+    simulator_init(&sim);
+    if ((view.size > SIMULATOR_MEMORY_SIZE) || (simulator_load(&sim, view.data, (uint32_t)view.size, 0, 0) == false))
+    {
+        printf("[FILE] File '%s' doesn't fit in memory (%llu bytes)\n", path, (unsigned long long)view.size);
+        simulator_free(&sim);
+        file_view_close(&view);
+        return -1;
+    }
+    file_view_close(&view);
+
+    const simulator_status_t status = simulator_run(&sim, EXECUTE_MAX_INST_COUNT);
+
+    output_buffer_t buffer;
+    output_buffer_init(&buffer, OUTPUT_BUFFER_DEFAULT_CAPACITY, stdout);
+    output_buffer_append_string(&buffer, "Final registers:\n");
+    simulator_format_registers(&sim, &buffer);
+    output_buffer_append_string(&buffer, "Stopped: ");
+    output_buffer_append_string(&buffer, simulator_get_status_name(status));
+    if (status == SIMULATOR_STATUS_INTERRUPT)
+    {
+        output_buffer_append_string(&buffer, " ");
+        output_buffer_append_uint(&buffer, sim.interrupt);
+    }
+    output_buffer_append_string(&buffer, " after ");
+    output_buffer_append_uint(&buffer, (uint32_t)sim.inst_count);
+    output_buffer_append_string(&buffer, " instructions\n");
+    output_buffer_free(&buffer);
 
-        /* Encode output assembly file */
-        system("nasm tmp.asm");
+    simulator_free(&sim);
+    return (status == SIMULATOR_STATUS_UNKNOWN_OPCODE) ? -1 : 0;
+}
 
-        /* Read in encoded data */
-        file = fopen("tmp", "rb");
-        if (file == NULL)
+/**
+ * Decode a file while collecting decode statistics and write the result to stdout, and a report of the statistics as a
+ * table or JSON to stderr. Only available when built with DECODER_STATS.
+*/
+static int decode_file_with_stats(const char* const path, const char* const report_format)
+{
+#if defined(DECODER_STATS)
+    const bool as_json = strcmp(report_format, "json") == 0;
+    if ((as_json == false) && (strcmp(report_format, "table") != 0))
+    {
+        printf("[STATS] Unknown report format '%s', expected 'table' or 'json'\n", report_format);
+        return -1;
+    }
+
+    file_view_t view;
+    if (file_view_open(&view, path) == false)
+    {
+        printf("[FILE] Failed to open file '%s'\n", path);
+        return -1;
+    }
+    if (view.size > UINT32_MAX)
+    {
+        printf("[FILE] File '%s' is too large (%llu bytes)\n", path, (unsigned long long)view.size);
+        file_view_close(&view);
+        return -1;
+    }
+
+    /* Build the tables up front so the first sample doesn't include it */
+    decoder_init();
+    decoder_stats_t stats;
+    decoder_stats_init(&stats);
+    output_buffer_t buffer;
+    output_buffer_init(&buffer, OUTPUT_BUFFER_DEFAULT_CAPACITY, stdout);
+    decoder_stream_t stream;
+    decoder_stream_init(&stream, &buffer);
+    stream.stats = &stats;
+    decoder_stream_feed(&stream, view.data, (uint32_t)view.size);
+    const bool success = decoder_stream_finish(&stream);
+    output_buffer_free(&buffer);
+
+    output_buffer_t report;
+    output_buffer_init(&report, 0, stderr);
+    decoder_stats_format(&stats, as_json, &report);
+    output_buffer_free(&report);
+
+    file_view_close(&view);
+    return (success == true) ? 0 : -1;
+#else
+    (void)path;
+    (void)report_format;
+    printf("[STATS] Decode statistics aren't available, build with DECODER_STATS defined\n");
+    return -1;
+#endif
+}
+
+/**
+ * Decode a file and check that encoding the instructions again, the way NASM would assemble the decoded text, gives
+ * back the original bytes.
+*/
+static int verify_file(const char* const path)
+{
+    /* Print current file */
+    printf("Verifying '%s'\n", path);
+
+    /* Map file */
+    file_view_t original;
+    if (file_view_open(&original, path) == false)
+    {
+        printf("\t[FILE] Failed to open file '%s'\n", path);
+        return -1;
+    }
+    if (original.size > UINT32_MAX)
+    {
+        printf("\t[FILE] File '%s' is too large (%llu bytes)\n", path, (unsigned long long)original.size);
+        file_view_close(&original);
+        return -1;
+    }
+
+    /* Decode and encode every instruction, and compare with the original */
+    uint32_t mismatch_offset;
+    const bool success = encoder_verify_stream(original.data, (uint32_t)original.size, &mismatch_offset);
+    file_view_close(&original);
+    if (success == false)
+    {
+        printf("\t[COMPARE] Instruction at offset %u doesn't encode back to the original bytes\n", mismatch_offset);
+        return -1;
+    }
+    printf("\t[COMPARE] Original and re-encoded instructions are equal\n\n");
+
+    return 0;
+}
+
+/**
+ * Parse a range written as "first..last", where 'last' is left out to mean everything after 'first'.
+*/
+static bool parse_range(const char* const text, uint32_t* const first, uint32_t* const last)
+{
+    char* end;
+    *first = (uint32_t)strtoul(text, &end, 10);
+    if ((end == text) || (strncmp(end, "..", 2) != 0))
+    {
+        return false;
+    }
+
+    const char* const last_text = end + 2;
+    if (*last_text == '\0')
+    {
+        *last = UINT32_MAX;
+        return true;
+    }
+    *last = (uint32_t)strtoul(last_text, &end, 10);
+    return *end == '\0';
+}
+
+/**
+ * Decode a range of instructions or bytes of a file and write the result to stdout. The boundary index of the file is
+ * kept next to it, so only the first lookup in a file has to scan it.
+*/
+static int decode_file_range(const char* const path, const char* const range, const bool is_byte_range)
+{
+    uint32_t first;
+    uint32_t last;
+    if (parse_range(range, &first, &last) == false)
+    {
+        printf("[RANGE] Invalid range '%s', expected 'first..last' or 'first..'\n", range);
+        return -1;
+    }
+
+    file_view_t view;
+    if (file_view_open(&view, path) == false)
+    {
+        printf("[FILE] Failed to open file '%s'\n", path);
+        return -1;
+    }
+    if (view.size > UINT32_MAX)
+    {
+        printf("[FILE] File '%s' is too large (%llu bytes)\n", path, (unsigned long long)view.size);
+        file_view_close(&view);
+        return -1;
+    }
+
+    const size_t index_path_len = strlen(path) + sizeof(INDEX_FILE_EXTENSION);
+    char* const index_path = malloc(index_path_len);
+    snprintf(index_path, index_path_len, "%s%s", path, INDEX_FILE_EXTENSION);
+    decoder_index_t index;
+    decoder_index_open(&index, view.data, (uint32_t)view.size, index_path);
+    free(index_path);
+
+    output_buffer_t buffer;
+    output_buffer_init(&buffer, OUTPUT_BUFFER_DEFAULT_CAPACITY, stdout);
+    bool success;
+    if (is_byte_range == true)
+    {
+        success = decoder_range_decode_bytes(view.data, (uint32_t)view.size, &index, first, last, &buffer);
+    }
+    else /* Instruction range */
+    {
+        success = decoder_range_decode_instructions(view.data, (uint32_t)view.size, &index, first, last, &buffer);
+    }
+    output_buffer_free(&buffer);
+
+    decoder_index_free(&index);
+    file_view_close(&view);
+    return (success == true) ? 0 : -1;
+}
+
+/**
+ * Decode and verify every file named by 'inputs' on 'thread_count' threads, and write a line per file and a summary to
+ * stdout. An input is a list file when it starts with '@', a pattern when it contains '*' or '?', a directory that's
+ * walked recursively, or else a single file.
+*/
+static int batch_files(const char* const* const inputs, const uint32_t input_count, const uint32_t thread_count)
+{
+    file_list_t files;
+    file_list_init(&files);
+    bool success = true;
+    for (uint32_t i = 0; i < input_count; i++)
+    {
+        const char* const input = inputs[i];
+        bool added = true;
+        if (input[0] == '@')
+        {
+            added = file_list_add_list_file(&files, input + 1);
+        }
+        else if (strpbrk(input, "*?") != NULL)
         {
-            printf("\t[FILE] Failed to open file 'tmp'\n");
-            return -1;
+            added = file_list_add_pattern(&files, input);
         }
-        fseek(file, 0, SEEK_END);
-        uint32_t file_size_result = (uint32_t)ftell(file);
-        fseek(file, 0, SEEK_SET);
-        uint8_t* file_data_result = malloc(file_size_result);
-        fread(file_data_result, file_size_result, 1, file);
-        fclose(file);
-
-        /* Compare original and new result */
-        if (file_size_original != file_size_result)
+        else if (file_list_is_directory(input) == true)
         {
-            printf("\t[COMPARE] Original size (%u) and result size (%u) aren't equal\n", file_size_original, file_size_result);
-            return;
+            added = file_list_add_directory(&files, input, batch_skip_extensions);
         }
-        if (memcmp(file_data_original, file_data_result, file_size_result) != 0)
+        else /* Single file */
         {
-            printf("\t[COMPARE] Content of original file and result file aren't the same\n");
-            return;
+            file_list_add(&files, input);
         }
-        printf("\t[COMPARE] Original and result file are equal\n\n");
 
-        free(file_data_result);
-        free(file_data_original);
+        if (added == false)
+        {
+            printf("[FILE] Failed to read input '%s'\n", input);
+            success = false;
+        }
     }
 
-    return 0;
+    decoder_batch_result_t* results = malloc(files.count * sizeof(decoder_batch_result_t));
+    decoder_batch_run((const char* const*)files.paths, files.count, thread_count, results);
+    output_buffer_t buffer;
+    output_buffer_init(&buffer, OUTPUT_BUFFER_DEFAULT_CAPACITY, stdout);
+    if (decoder_batch_format_results(results, files.count, &buffer) > 0)
+    {
+        success = false;
+    }
+    output_buffer_free(&buffer);
+
+    free(results);
+    file_list_free(&files);
+    return (success == true) ? 0 : -1;
+}
+
+int main(int argc, char** argv)
+{
+    /* Decode stdin when asked to */
+    if ((argc == 2) && (strcmp(argv[1], "-") == 0))
+    {
+        return decode_stdin();
+    }
+
+    /* Decode a file on several threads, 0 threads means one per processor */
+    if ((argc == 4) && (strcmp(argv[1], "-j") == 0))
+    {
+        return decode_file_parallel(argv[3], (uint32_t)strtoul(argv[2], NULL, 10));
+    }
+
+    /* Decode a file through a cache of decoded instructions, 0 entries means the default size. Wins above 60% hits */
+    if ((argc == 4) && (strcmp(argv[1], "-c") == 0))
+    {
+        return decode_file_cached(argv[3], (uint32_t)strtoul(argv[2], NULL, 10));
+    }
+
+    /* Write a binary listing of a file, or print a binary listing as text */
+    if ((argc == 3) && (strcmp(argv[1], "-r") == 0))
+    {
+        return decode_file_binary(argv[2]);
+    }
+    if ((argc == 3) && (strcmp(argv[1], "-R") == 0))
+    {
+        return print_binary_listing(argv[2]);
+    }
+
+    /* Decode a file front to back with labels for branch targets */
+    if ((argc == 3) && (strcmp(argv[1], "-l") == 0))
+    {
+        return decode_file_with_labels(argv[2]);
+    }
+
+    /* Disassemble by following control flow from entry points, offsets default to the start of the file */
+    if ((argc >= 3) && (strcmp(argv[1], "-t") == 0))
+    {
+        return disassemble_file_flow(argv[2], (const char* const*)(argv + 3), (uint32_t)(argc - 3));
+    }
+
+    /* Execute a file and print the final registers */
+    if ((argc == 3) && (strcmp(argv[1], "-x") == 0))
+    {
+        return execute_file(argv[2]);
+    }
+
+    /* Decode a file and report statistics, as a 'table' or as 'json' */
+    if ((argc == 4) && (strcmp(argv[1], "-s") == 0))
+    {
+        return decode_file_with_stats(argv[3], argv[2]);
+    }
+
+    /* Decode part of a file, '-i' takes a range of instructions and '-b' a range of bytes */
+    if ((argc == 4) && ((strcmp(argv[1], "-i") == 0) || (strcmp(argv[1], "-b") == 0)))
+    {
+        return decode_file_range(argv[3], argv[2], argv[1][1] == 'b');
+    }
+
+    /* Verify a single file */
+    if ((argc == 3) && (strcmp(argv[1], "-v") == 0))
+    {
+        return verify_file(argv[2]);
+    }
+
+    /* Decode and verify many files, 0 threads means one per processor */
+    if ((argc >= 4) && (strcmp(argv[1], "-B") == 0))
+    {
+        return batch_files((const char* const*)(argv + 3), (uint32_t)(argc - 3), (uint32_t)strtoul(argv[2], NULL, 10));
+    }
+
+    /* Verify all test files */
+    const char* const default_input = DEFAULT_BATCH_DIRECTORY;
+    return batch_files(&default_input, 1, 0);
 }
@@ -0,0 +1,90 @@
+/*
+Copyright (c) 2023 Daniel Fedai Larsen
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "cpu.h"
+
+#if defined(CPU_X86) && defined(_MSC_VER)
+
+#include <intrin.h>
+
+/* CPUID leaf 1 ECX and leaf 7 EBX feature bits */
+#define CPU_LEAF1_ECX_SSSE3   (1 << 9)
+#define CPU_LEAF1_ECX_OSXSAVE (1 << 27)
+#define CPU_LEAF1_ECX_AVX     (1 << 28)
+#define CPU_LEAF7_EBX_AVX2    (1 << 5)
+/* XCR0 bits for the XMM and YMM state */
+#define CPU_XCR0_XMM_YMM      0x6
+
+bool cpu_has_ssse3(void)
+{
+    int info[4];
+    __cpuid(info, 1);
+    return (info[2] & CPU_LEAF1_ECX_SSSE3) != 0;
+}
+
+bool cpu_has_avx2(void)
+{
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7)
+    {
+        return false;
+    }
+
+    __cpuid(info, 1);
+    const int required = CPU_LEAF1_ECX_OSXSAVE | CPU_LEAF1_ECX_AVX;
+    if (((info[2] & required) != required) || ((_xgetbv(0) & CPU_XCR0_XMM_YMM) != CPU_XCR0_XMM_YMM))
+    {
+        return false;
+    }
+
+    __cpuidex(info, 7, 0);
+    return (info[1] & CPU_LEAF7_EBX_AVX2) != 0;
+}
+
+#elif defined(CPU_X86)
+
+/* GCC and Clang check the OS support as well */
+bool cpu_has_ssse3(void)
+{
+    return __builtin_cpu_supports("ssse3") != 0;
+}
+
+bool cpu_has_avx2(void)
+{
+    return __builtin_cpu_supports("avx2") != 0;
+}
+
+#else
+
+bool cpu_has_ssse3(void)
+{
+    return false;
+}
+
+bool cpu_has_avx2(void)
+{
+    return false;
+}
+
+#endif
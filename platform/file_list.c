@@ -0,0 +1,335 @@
+/*
+Copyright (c) 2023 Daniel Fedai Larsen
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "file_list.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <glob.h>
+#include <sys/stat.h>
+#endif
+
+#define FILE_LIST_DEFAULT_CAPACITY 64U
+/* Longest line read from a list file */
+#define FILE_LIST_LINE_MAX 4096U
+
+static int file_list_compare_paths(const void* a, const void* b)
+{
+    return strcmp(*(const char* const*)a, *(const char* const*)b);
+}
+
+static void file_list_sort_from(file_list_t* const list, const uint32_t first)
+{
+    qsort(list->paths + first, list->count - first, sizeof(char*), file_list_compare_paths);
+}
+
+static bool file_list_has_extension(const char* const path, const char* const* const extensions)
+{
+    if (extensions == NULL)
+    {
+        return false;
+    }
+
+    const size_t path_len = strlen(path);
+    for (uint32_t i = 0; extensions[i] != NULL; i++)
+    {
+        const size_t extension_len = strlen(extensions[i]);
+        if ((path_len >= extension_len) && (strcmp(path + path_len - extension_len, extensions[i]) == 0))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * Join a directory and a name into a new heap string.
+*/
+static char* file_list_join(const char* const directory, const char* const name)
+{
+    const size_t len = strlen(directory) + 1 + strlen(name) + 1;
+    char* path = malloc(len);
+    snprintf(path, len, "%s/%s", directory, name);
+    return path;
+}
+
+void file_list_init(file_list_t* const list)
+{
+    list->capacity = FILE_LIST_DEFAULT_CAPACITY;
+    list->paths = malloc(list->capacity * sizeof(char*));
+    list->count = 0;
+}
+
+void file_list_free(file_list_t* const list)
+{
+    for (uint32_t i = 0; i < list->count; i++)
+    {
+        free(list->paths[i]);
+    }
+    free(list->paths);
+    list->paths = NULL;
+    list->count = 0;
+    list->capacity = 0;
+}
+
+void file_list_add(file_list_t* const list, const char* const path)
+{
+    if (list->count == list->capacity)
+    {
+        list->capacity *= 2;
+        list->paths = realloc(list->paths, list->capacity * sizeof(char*));
+    }
+
+    const size_t len = strlen(path) + 1;
+    list->paths[list->count] = malloc(len);
+    memcpy(list->paths[list->count], path, len);
+    list->count++;
+}
+
+bool file_list_add_list_file(file_list_t* const list, const char* const path)
+{
+    FILE* file = fopen(path, "r");
+    if (file == NULL)
+    {
+        return false;
+    }
+
+    char line[FILE_LIST_LINE_MAX];
+    while (fgets(line, sizeof(line), file) != NULL)
+    {
+        /* Strip the line ending, CRLF included */
+        size_t len = strlen(line);
+        while ((len > 0) && ((line[len - 1] == '\n') || (line[len - 1] == '\r')))
+        {
+            len--;
+        }
+        line[len] = '\0';
+        if (len > 0)
+        {
+            file_list_add(list, line);
+        }
+    }
+
+    const bool success = ferror(file) == 0;
+    fclose(file);
+    return success;
+}
+
+#if defined(_WIN32)
+
+bool file_list_is_directory(const char* const path)
+{
+    const DWORD attributes = GetFileAttributesA(path);
+    return (attributes != INVALID_FILE_ATTRIBUTES) && ((attributes & FILE_ATTRIBUTE_DIRECTORY) != 0);
+}
+
+bool file_list_add_directory(file_list_t* const list, const char* const path, const char* const* const skip_extensions)
+{
+    char* pattern = file_list_join(path, "*");
+    WIN32_FIND_DATAA find_data;
+    HANDLE find_handle = FindFirstFileA(pattern, &find_data);
+    free(pattern);
+    if (find_handle == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+
+    /* Files of this directory first, sorted, then each subdirectory in turn */
+    const uint32_t first = list->count;
+    file_list_t directories;
+    file_list_init(&directories);
+    do
+    {
+        if ((strcmp(find_data.cFileName, ".") == 0) || (strcmp(find_data.cFileName, "..") == 0))
+        {
+            continue;
+        }
+
+        /* Junctions and linked directories can lead back up the tree, only walk real directories */
+        char* entry = file_list_join(path, find_data.cFileName);
+        if (find_data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+        {
+            if ((find_data.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT) == 0)
+            {
+                file_list_add(&directories, entry);
+            }
+        }
+        else if (file_list_has_extension(entry, skip_extensions) == false)
+        {
+            file_list_add(list, entry);
+        }
+        free(entry);
+    } while (FindNextFileA(find_handle, &find_data) != FALSE);
+    FindClose(find_handle);
+
+    file_list_sort_from(list, first);
+    file_list_sort_from(&directories, 0);
+    for (uint32_t i = 0; i < directories.count; i++)
+    {
+        file_list_add_directory(list, directories.paths[i], skip_extensions);
+    }
+    file_list_free(&directories);
+
+    return true;
+}
+
+bool file_list_add_pattern(file_list_t* const list, const char* const pattern)
+{
+    /* FindFirstFile only gives names, keep the directory part of the pattern */
+    const char* name = pattern;
+    for (const char* c = pattern; *c != '\0'; c++)
+    {
+        if ((*c == '/') || (*c == '\\'))
+        {
+            name = c + 1;
+        }
+    }
+    const size_t directory_len = (size_t)(name - pattern);
+
+    WIN32_FIND_DATAA find_data;
+    HANDLE find_handle = FindFirstFileA(pattern, &find_data);
+    if (find_handle == INVALID_HANDLE_VALUE)
+    {
+        return GetLastError() == ERROR_FILE_NOT_FOUND;
+    }
+
+    const uint32_t first = list->count;
+    do
+    {
+        if (find_data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+        {
+            continue;
+        }
+
+        const size_t len = directory_len + strlen(find_data.cFileName) + 1;
+        char* entry = malloc(len);
+        memcpy(entry, pattern, directory_len);
+        memcpy(entry + directory_len, find_data.cFileName, len - directory_len);
+        file_list_add(list, entry);
+        free(entry);
+    } while (FindNextFileA(find_handle, &find_data) != FALSE);
+    FindClose(find_handle);
+
+    file_list_sort_from(list, first);
+    return true;
+}
+
+#else
+
+bool file_list_is_directory(const char* const path)
+{
+    struct stat file_stat;
+    return (stat(path, &file_stat) == 0) && S_ISDIR(file_stat.st_mode);
+}
+
+bool file_list_add_directory(file_list_t* const list, const char* const path, const char* const* const skip_extensions)
+{
+    DIR* directory = opendir(path);
+    if (directory == NULL)
+    {
+        return false;
+    }
+
+    /* Files of this directory first, sorted, then each subdirectory in turn */
+    const uint32_t first = list->count;
+    file_list_t directories;
+    file_list_init(&directories);
+    struct dirent* directory_entry;
+    while ((directory_entry = readdir(directory)) != NULL)
+    {
+        if ((strcmp(directory_entry->d_name, ".") == 0) || (strcmp(directory_entry->d_name, "..") == 0))
+        {
+            continue;
+        }
+
+        /* Linked directories can lead back up the tree, only walk real directories but follow links to files */
+        char* entry = file_list_join(path, directory_entry->d_name);
+        struct stat file_stat;
+        bool is_found = lstat(entry, &file_stat) == 0;
+        if ((is_found == true) && S_ISLNK(file_stat.st_mode))
+        {
+            is_found = (stat(entry, &file_stat) == 0) && (S_ISDIR(file_stat.st_mode) == false);
+        }
+        if (is_found == true)
+        {
+            if (S_ISDIR(file_stat.st_mode))
+            {
+                file_list_add(&directories, entry);
+            }
+            else if (S_ISREG(file_stat.st_mode) && (file_list_has_extension(entry, skip_extensions) == false))
+            {
+                file_list_add(list, entry);
+            }
+        }
+        free(entry);
+    }
+    closedir(directory);
+
+    file_list_sort_from(list, first);
+    file_list_sort_from(&directories, 0);
+    for (uint32_t i = 0; i < directories.count; i++)
+    {
+        file_list_add_directory(list, directories.paths[i], skip_extensions);
+    }
+    file_list_free(&directories);
+
+    return true;
+}
+
+bool file_list_add_pattern(file_list_t* const list, const char* const pattern)
+{
+    glob_t matches;
+    const int result = glob(pattern, GLOB_MARK, NULL, &matches);
+    if (result == GLOB_NOMATCH)
+    {
+        return true;
+    }
+    if (result != 0)
+    {
+        return false;
+    }
+
+    /* glob sorts its matches, GLOB_MARK puts a slash after directories so they can be skipped */
+    for (size_t i = 0; i < matches.gl_pathc; i++)
+    {
+        const char* const match = matches.gl_pathv[i];
+        const size_t len = strlen(match);
+        if ((len > 0) && (match[len - 1] != '/'))
+        {
+            file_list_add(list, match);
+        }
+    }
+    globfree(&matches);
+
+    return true;
+}
+
+#endif
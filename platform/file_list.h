@@ -0,0 +1,84 @@
+/*
+Copyright (c) 2023 Daniel Fedai Larsen
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef FILE_LIST_H
+#define FILE_LIST_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * Growable list of file paths. The list owns copies of the paths.
+*/
+typedef struct
+{
+    char** paths;
+    uint32_t count;
+    uint32_t capacity;
+} file_list_t;
+
+/**
+ * @brief Initialize an empty list
+*/
+void file_list_init(file_list_t* const list);
+
+/**
+ * @brief Free the list and all its paths
+*/
+void file_list_free(file_list_t* const list);
+
+/**
+ * @brief Add a copy of a path to the end of the list
+*/
+void file_list_add(file_list_t* const list, const char* const path);
+
+/**
+ * @brief Add every file in a directory and its subdirectories, in sorted order
+ *
+ * @param list List to add to
+ * @param path Directory to walk
+ * @param skip_extensions Files ending in one of these (e.g. ".asm") are left out, NULL-terminated, may be NULL
+ * @return false if the directory couldn't be opened
+*/
+bool file_list_add_directory(file_list_t* const list, const char* const path, const char* const* const skip_extensions);
+
+/**
+ * @brief Add every file matching a wildcard pattern ('*' and '?'), in sorted order
+ *
+ * @return false if the pattern couldn't be expanded, a pattern that matches nothing adds nothing
+*/
+bool file_list_add_pattern(file_list_t* const list, const char* const pattern);
+
+/**
+ * @brief Add every path listed in a text file, one per line, blank lines are skipped
+ *
+ * @return false if the file couldn't be read
+*/
+bool file_list_add_list_file(file_list_t* const list, const char* const path);
+
+/**
+ * @brief Check whether a path is a directory
+*/
+bool file_list_is_directory(const char* const path);
+
+#endif
@@ -0,0 +1,226 @@
+/*
+Copyright (c) 2023 Daniel Fedai Larsen
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "file_view.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/* Size of each read when the file can't be mapped */
+#define FILE_VIEW_READ_CHUNK_SIZE (size_t)(1U << 16)
+
+/**
+ * Read everything from 'file' into a heap buffer. Used for inputs that can't be mapped, like pipes.
+*/
+static bool file_view_read_all(file_view_t* const view, FILE* file)
+{
+    uint8_t* data = NULL;
+    size_t size = 0;
+    size_t capacity = 0;
+    while (true)
+    {
+        if ((capacity - size) < FILE_VIEW_READ_CHUNK_SIZE)
+        {
+            capacity = (capacity == 0) ? FILE_VIEW_READ_CHUNK_SIZE : capacity * 2;
+            uint8_t* new_data = realloc(data, capacity);
+            if (new_data == NULL)
+            {
+                free(data);
+                return false;
+            }
+            data = new_data;
+        }
+
+        const size_t read_size = fread(data + size, 1, capacity - size, file);
+        size += read_size;
+        if (read_size == 0)
+        {
+            break;
+        }
+    }
+
+    if (ferror(file))
+    {
+        free(data);
+        return false;
+    }
+
+    view->data = data;
+    view->size = size;
+    view->is_mapped = false;
+    return true;
+}
+
+#if defined(_WIN32)
+
+bool file_view_open(file_view_t* const view, const char* const path)
+{
+    view->data = NULL;
+    view->size = 0;
+    view->is_mapped = false;
+    view->mapping_handle = NULL;
+
+    HANDLE file_handle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (file_handle == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+
+    /* Only regular files on disk can be mapped */
+    LARGE_INTEGER file_size;
+    if ((GetFileType(file_handle) != FILE_TYPE_DISK) || (GetFileSizeEx(file_handle, &file_size) == FALSE))
+    {
+        CloseHandle(file_handle);
+        FILE* file = fopen(path, "rb");
+        if (file == NULL)
+        {
+            return false;
+        }
+        const bool result = file_view_read_all(view, file);
+        fclose(file);
+        return result;
+    }
+
+    /* Empty files can't be mapped, but they're valid input */
+    if (file_size.QuadPart == 0)
+    {
+        CloseHandle(file_handle);
+        return true;
+    }
+
+    HANDLE mapping_handle = CreateFileMappingA(file_handle, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(file_handle);
+    if (mapping_handle == NULL)
+    {
+        return false;
+    }
+    const void* data = MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0);
+    if (data == NULL)
+    {
+        CloseHandle(mapping_handle);
+        return false;
+    }
+
+    view->data = data;
+    view->size = (uint64_t)file_size.QuadPart;
+    view->is_mapped = true;
+    view->mapping_handle = mapping_handle;
+    return true;
+}
+
+void file_view_close(file_view_t* const view)
+{
+    if (view->is_mapped == true)
+    {
+        UnmapViewOfFile(view->data);
+        CloseHandle(view->mapping_handle);
+    }
+    else /* view->is_mapped == false */
+    {
+        free((void*)view->data);
+    }
+
+    view->data = NULL;
+    view->size = 0;
+    view->is_mapped = false;
+    view->mapping_handle = NULL;
+}
+
+#else
+
+bool file_view_open(file_view_t* const view, const char* const path)
+{
+    view->data = NULL;
+    view->size = 0;
+    view->is_mapped = false;
+
+    const int fd = open(path, O_RDONLY);
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    /* Only regular files can be mapped */
+    struct stat file_stat;
+    if ((fstat(fd, &file_stat) != 0) || (S_ISREG(file_stat.st_mode) == false))
+    {
+        FILE* file = fdopen(fd, "rb");
+        if (file == NULL)
+        {
+            close(fd);
+            return false;
+        }
+        const bool result = file_view_read_all(view, file);
+        fclose(file);
+        return result;
+    }
+
+    /* Empty files can't be mapped, but they're valid input */
+    if (file_stat.st_size == 0)
+    {
+        close(fd);
+        return true;
+    }
+
+    void* data = mmap(NULL, (size_t)file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED)
+    {
+        return false;
+    }
+    /* The decoder reads front to back, so let the kernel read ahead aggressively */
+    madvise(data, (size_t)file_stat.st_size, MADV_SEQUENTIAL);
+
+    view->data = data;
+    view->size = (uint64_t)file_stat.st_size;
+    view->is_mapped = true;
+    return true;
+}
+
+void file_view_close(file_view_t* const view)
+{
+    if (view->is_mapped == true)
+    {
+        munmap((void*)view->data, (size_t)view->size);
+    }
+    else /* view->is_mapped == false */
+    {
+        free((void*)view->data);
+    }
+
+    view->data = NULL;
+    view->size = 0;
+    view->is_mapped = false;
+}
+
+#endif
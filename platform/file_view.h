@@ -0,0 +1,60 @@
+/*
+Copyright (c) 2023 Daniel Fedai Larsen
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef FILE_VIEW_H
+#define FILE_VIEW_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * Read-only view of a whole file. Regular files are memory-mapped, anything that can't be mapped (pipes, character
+ * devices) is read into a heap buffer instead.
+*/
+typedef struct
+{
+    const uint8_t* data;
+    uint64_t size;
+    bool is_mapped;
+#if defined(_WIN32)
+    void* mapping_handle;
+#endif
+} file_view_t;
+
+/**
+ * @brief Open a read-only view of a file
+ *
+ * @param view View to initialize
+ * @param path Path of the file to open
+ * @return false if the file couldn't be opened or read
+*/
+bool file_view_open(file_view_t* const view, const char* const path);
+
+/**
+ * @brief Unmap or free the data of a view
+ *
+ * @param view View to close
+*/
+void file_view_close(file_view_t* const view);
+
+#endif
@@ -0,0 +1,99 @@
+/*
+Copyright (c) 2023 Daniel Fedai Larsen
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "thread.h"
+
+#if defined(_WIN32)
+
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+
+static DWORD WINAPI thread_entry(LPVOID parameter)
+{
+    thread_t* thread = (thread_t*)parameter;
+    thread->function(thread->argument);
+    return 0;
+}
+
+bool thread_create(thread_t* const thread, const thread_function_t function, void* const argument)
+{
+    thread->function = function;
+    thread->argument = argument;
+    thread->handle = CreateThread(NULL, 0, thread_entry, thread, 0, NULL);
+    return thread->handle != NULL;
+}
+
+void thread_join(thread_t* const thread)
+{
+    WaitForSingleObject(thread->handle, INFINITE);
+    CloseHandle(thread->handle);
+    thread->handle = NULL;
+}
+
+uint32_t thread_get_processor_count(void)
+{
+    SYSTEM_INFO system_info;
+    GetSystemInfo(&system_info);
+    return (uint32_t)system_info.dwNumberOfProcessors;
+}
+
+uint32_t thread_atomic_increment(volatile uint32_t* const counter)
+{
+    return (uint32_t)InterlockedIncrement((volatile LONG*)counter) - 1;
+}
+
+#else
+
+#include <unistd.h>
+
+static void* thread_entry(void* parameter)
+{
+    thread_t* thread = (thread_t*)parameter;
+    thread->function(thread->argument);
+    return NULL;
+}
+
+bool thread_create(thread_t* const thread, const thread_function_t function, void* const argument)
+{
+    thread->function = function;
+    thread->argument = argument;
+    return pthread_create(&thread->handle, NULL, thread_entry, thread) == 0;
+}
+
+void thread_join(thread_t* const thread)
+{
+    pthread_join(thread->handle, NULL);
+}
+
+uint32_t thread_get_processor_count(void)
+{
+    const long processor_count = sysconf(_SC_NPROCESSORS_ONLN);
+    return (processor_count > 0) ? (uint32_t)processor_count : 1;
+}
+
+uint32_t thread_atomic_increment(volatile uint32_t* const counter)
+{
+    return __atomic_fetch_add(counter, 1, __ATOMIC_RELAXED);
+}
+
+#endif
@@ -0,0 +1,80 @@
+/*
+Copyright (c) 2023 Daniel Fedai Larsen
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef THREAD_H
+#define THREAD_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#if !defined(_WIN32)
+#include <pthread.h>
+#endif
+
+typedef void (*thread_function_t)(void* argument);
+
+/**
+ * Native thread running 'function(argument)'. The struct must stay alive until the thread has been joined.
+*/
+typedef struct
+{
+#if defined(_WIN32)
+    void* handle;
+#else
+    pthread_t handle;
+#endif
+    thread_function_t function;
+    void* argument;
+} thread_t;
+
+/**
+ * @brief Start a thread
+ *
+ * @param thread Thread to start
+ * @param function Function to run on the new thread
+ * @param argument Argument passed to 'function'
+ * @return false if the thread couldn't be created
+*/
+bool thread_create(thread_t* const thread, const thread_function_t function, void* const argument);
+
+/**
+ * @brief Wait for a thread to finish
+ *
+ * @param thread Thread to wait for
+*/
+void thread_join(thread_t* const thread);
+
+/**
+ * @brief Get the number of logical processors
+*/
+uint32_t thread_get_processor_count(void);
+
+/**
+ * @brief Atomically add one to a counter shared between threads
+ *
+ * @param counter Counter to increment
+ * @return Value of the counter before it was incremented
+*/
+uint32_t thread_atomic_increment(volatile uint32_t* const counter);
+
+#endif
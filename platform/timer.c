@@ -0,0 +1,75 @@
+/*
+Copyright (c) 2023 Daniel Fedai Larsen
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "timer.h"
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define TIMER_HAS_CYCLE_COUNTER
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define TIMER_HAS_CYCLE_COUNTER
+#endif
+
+uint64_t timer_get_cycles(void)
+{
+#if defined(TIMER_HAS_CYCLE_COUNTER)
+    return __rdtsc();
+#else
+    return timer_get_nanoseconds();
+#endif
+}
+
+#if defined(_WIN32)
+
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+
+uint64_t timer_get_nanoseconds(void)
+{
+    static LARGE_INTEGER frequency;
+    if (frequency.QuadPart == 0)
+    {
+        QueryPerformanceFrequency(&frequency);
+    }
+
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter(&counter);
+    /* Split the conversion so the multiplication can't overflow */
+    const uint64_t seconds = (uint64_t)counter.QuadPart / (uint64_t)frequency.QuadPart;
+    const uint64_t remainder = (uint64_t)counter.QuadPart % (uint64_t)frequency.QuadPart;
+    return (seconds * 1000000000ULL) + ((remainder * 1000000000ULL) / (uint64_t)frequency.QuadPart);
+}
+
+#else
+
+#include <time.h>
+
+uint64_t timer_get_nanoseconds(void)
+{
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return ((uint64_t)time.tv_sec * 1000000000ULL) + (uint64_t)time.tv_nsec;
+}
+
+#endif
@@ -0,0 +1,46 @@
+/*
+Copyright (c) 2023 Daniel Fedai Larsen
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef TIMER_H
+#define TIMER_H
+
+#include <stdint.h>
+
+/**
+ * @brief Read a monotonic clock
+ *
+ * @return Nanoseconds since an arbitrary point in time, only differences between two calls are meaningful
+*/
+uint64_t timer_get_nanoseconds(void);
+
+/**
+ * @brief Read the processor's cycle counter, or the monotonic clock where there is none
+ *
+ * Much cheaper than timer_get_nanoseconds() on x86, but the rate isn't known and may differ between processors, so
+ * only compare counts taken on the same machine.
+ *
+ * @return Cycles since an arbitrary point in time
+*/
+uint64_t timer_get_cycles(void);
+
+#endif
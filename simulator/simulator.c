@@ -0,0 +1,1336 @@
+/*
+Copyright (c) 2023 Daniel Fedai Larsen
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "simulator.h"
+
+#include "decoder.h"
+#include "instruction.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/* Flags set by arithmetic and logic instructions */
+#define SIMULATOR_FLAGS_ARITHMETIC (SIMULATOR_FLAG_CF | SIMULATOR_FLAG_PF | SIMULATOR_FLAG_AF | SIMULATOR_FLAG_ZF | SIMULATOR_FLAG_SF | SIMULATOR_FLAG_OF)
+/* Flags LAHF and SAHF move between AH and the flags register */
+#define SIMULATOR_FLAGS_LOW (SIMULATOR_FLAG_CF | SIMULATOR_FLAG_PF | SIMULATOR_FLAG_AF | SIMULATOR_FLAG_ZF | SIMULATOR_FLAG_SF)
+/* Flags POPF and IRET can change */
+#define SIMULATOR_FLAGS_ALL (SIMULATOR_FLAGS_ARITHMETIC | SIMULATOR_FLAG_TF | SIMULATOR_FLAG_IF | SIMULATOR_FLAG_DF)
+/* Bit 1 always reads as one and the top four bits are set when the flags are pushed */
+#define SIMULATOR_FLAGS_FIXED (uint16_t)0x0002
+#define SIMULATOR_FLAGS_PUSHED (uint16_t)0xF000
+
+/* Interrupt vectors the processor raises itself */
+#define SIMULATOR_VECTOR_DIVIDE_ERROR 0U
+#define SIMULATOR_VECTOR_BREAKPOINT 3U
+#define SIMULATOR_VECTOR_OVERFLOW 4U
+
+/* Index of a word register in 'registers' */
+#define REG(id) ((id) - REGISTER_AX)
+#define AX sim->registers[REG(REGISTER_AX)]
+#define CX sim->registers[REG(REGISTER_CX)]
+#define DX sim->registers[REG(REGISTER_DX)]
+#define BX sim->registers[REG(REGISTER_BX)]
+#define SP sim->registers[REG(REGISTER_SP)]
+#define BP sim->registers[REG(REGISTER_BP)]
+#define SI sim->registers[REG(REGISTER_SI)]
+#define DI sim->registers[REG(REGISTER_DI)]
+#define ES sim->registers[REG(REGISTER_ES)]
+#define CS sim->registers[REG(REGISTER_CS)]
+#define SS sim->registers[REG(REGISTER_SS)]
+#define DS sim->registers[REG(REGISTER_DS)]
+
+static const char* const status_names[SIMULATOR_STATUS_COUNT] = {
+    "running",
+    "end of program",
+    "halted",
+    "interrupt",
+    "unknown opcode",
+    "instruction limit",
+};
+
+static const char* const register_names[SIMULATOR_REGISTER_COUNT] = {
+    "ax", "cx", "dx", "bx", "sp", "bp", "si", "di", "es", "cs", "ss", "ds",
+};
+
+static uint32_t simulator_get_linear(const uint16_t segment, const uint16_t offset)
+{
+    return (((uint32_t)segment << 4) + offset) & SIMULATOR_ADDRESS_MASK;
+}
+
+static uint16_t simulator_read_word(const simulator_t* const sim, const uint32_t address)
+{
+    return (uint16_t)sim->memory[address] | ((uint16_t)sim->memory[(address + 1) & SIMULATOR_ADDRESS_MASK] << 8);
+}
+
+/**
+ * Every write to memory goes through here, a write to a byte of decoded code drops the blocks it changes.
+*/
+static void simulator_write_byte(simulator_t* const sim, const uint32_t address, const uint8_t value)
+{
+    sim->memory[address] = value;
+    if (sim->blocks.code_bits[address >> 3] & (1U << (address & 7)))
+    {
+        simulator_blocks_invalidate(&sim->blocks, address, address + 1);
+    }
+}
+
+static void simulator_write_word(simulator_t* const sim, const uint32_t address, const uint16_t value)
+{
+    simulator_write_byte(sim, address, (uint8_t)value);
+    simulator_write_byte(sim, (address + 1) & SIMULATOR_ADDRESS_MASK, (uint8_t)(value >> 8));
+}
+
+static void simulator_push(simulator_t* const sim, const uint16_t value)
+{
+    SP -= 2;
+    simulator_write_word(sim, simulator_get_linear(SS, SP), value);
+}
+
+static uint16_t simulator_pop(simulator_t* const sim)
+{
+    const uint16_t value = simulator_read_word(sim, simulator_get_linear(SS, SP));
+    SP += 2;
+    return value;
+}
+
+/**
+ * Byte registers AL to BH are the low and high halves of AX to BX.
+*/
+static uint8_t* simulator_get_byte_register(simulator_t* const sim, const uint8_t id)
+{
+    return (uint8_t*)&sim->registers[id & 0x3] + (id >> 2);
+}
+
+/**
+ * Offset of a memory operand in its segment, see Table 4-10 in the manual. Direct addresses have a displacement of
+ * zero added to nothing, and a missing displacement was decoded as zero.
+*/
+static uint16_t simulator_get_effective_address(const simulator_t* const sim, const uint8_t effective_address, const uint16_t displacement)
+{
+    switch (effective_address)
+    {
+        case EFFECTIVE_ADDRESS_BX_SI: return (uint16_t)(BX + SI + displacement);
+        case EFFECTIVE_ADDRESS_BX_DI: return (uint16_t)(BX + DI + displacement);
+        case EFFECTIVE_ADDRESS_BP_SI: return (uint16_t)(BP + SI + displacement);
+        case EFFECTIVE_ADDRESS_BP_DI: return (uint16_t)(BP + DI + displacement);
+        case EFFECTIVE_ADDRESS_SI:    return (uint16_t)(SI + displacement);
+        case EFFECTIVE_ADDRESS_DI:    return (uint16_t)(DI + displacement);
+        case EFFECTIVE_ADDRESS_BP:    return (uint16_t)(BP + displacement);
+        case EFFECTIVE_ADDRESS_BX:    return (uint16_t)(BX + displacement);
+        default:                      return displacement; /* EFFECTIVE_ADDRESS_DIRECT */
+    }
+}
+
+/**
+ * Segment a memory operand is in, SS for addresses based on BP and DS for all others unless overridden.
+*/
+static uint16_t simulator_get_segment(const simulator_t* const sim, const instruction_t* const inst, const uint8_t effective_address)
+{
+    if (inst->flags & INSTRUCTION_FLAG_SEGMENT_OVERRIDE)
+    {
+        return sim->registers[REG(inst->segment)];
+    }
+    if ((effective_address == EFFECTIVE_ADDRESS_BP_SI) || (effective_address == EFFECTIVE_ADDRESS_BP_DI) ||
+        (effective_address == EFFECTIVE_ADDRESS_BP))
+    {
+        return SS;
+    }
+
+    return DS;
+}
+
+/**
+ * Linear address of an operand, only meaningful for memory operands.
+*/
+static uint32_t simulator_get_address(const simulator_t* const sim, const instruction_t* const inst, const operand_t* const operand)
+{
+    if (operand->kind != OPERAND_MEMORY)
+    {
+        return 0;
+    }
+
+    const uint16_t offset = simulator_get_effective_address(sim, operand->value, inst->displacement);
+    return simulator_get_linear(simulator_get_segment(sim, inst, operand->value), offset);
+}
+
+/**
+ * Value of an operand. Registers have the width of their name, memory has the width of the instruction.
+*/
+static uint16_t simulator_read(simulator_t* const sim, const instruction_t* const inst, const operand_t* const operand, const uint32_t address)
+{
+    switch (operand->kind)
+    {
+        case OPERAND_REGISTER:
+        {
+            if (operand->value < REGISTER_AX)
+            {
+                return *simulator_get_byte_register(sim, operand->value);
+            }
+            return sim->registers[REG(operand->value)];
+        }
+        case OPERAND_MEMORY:
+        {
+            return (inst->w == 1) ? simulator_read_word(sim, address) : sim->memory[address];
+        }
+        default: /* Immediate */
+        {
+            return inst->immediate;
+        }
+    }
+}
+
+static void simulator_write(simulator_t* const sim, const instruction_t* const inst, const operand_t* const operand, const uint32_t address, const uint16_t value)
+{
+    if (operand->kind == OPERAND_REGISTER)
+    {
+        if (operand->value < REGISTER_AX)
+        {
+            *simulator_get_byte_register(sim, operand->value) = (uint8_t)value;
+        }
+        else /* Word register */
+        {
+            sim->registers[REG(operand->value)] = value;
+        }
+    }
+    else if (inst->w == 1)
+    {
+        simulator_write_word(sim, address, value);
+    }
+    else /* Byte in memory */
+    {
+        simulator_write_byte(sim, address, (uint8_t)value);
+    }
+}
+
+/**
+ * ZF, SF and PF of a result. PF is set when the low byte has an even number of one bits.
+*/
+static uint16_t simulator_get_result_flags(const uint16_t result, const uint8_t w)
+{
+    const uint16_t sign = (w == 1) ? 0x8000 : 0x80;
+    const uint16_t mask = (w == 1) ? 0xFFFF : 0xFF;
+    uint8_t low = (uint8_t)result;
+    low ^= low >> 4;
+
+    uint16_t flags = 0;
+    if ((result & mask) == 0)
+    {
+        flags |= SIMULATOR_FLAG_ZF;
+    }
+    if (result & sign)
+    {
+        flags |= SIMULATOR_FLAG_SF;
+    }
+    if ((0x9669 >> (low & 0xF)) & 1)
+    {
+        flags |= SIMULATOR_FLAG_PF;
+    }
+    return flags;
+}
+
+/**
+ * CF of the lazy operation, INC and DEC keep the CF they found.
+*/
+static bool simulator_get_lazy_carry(const simulator_lazy_flags_t* const lazy)
+{
+    const uint32_t mask = (lazy->w == 1) ? 0xFFFF : 0xFF;
+    switch (lazy->operation)
+    {
+        case SIMULATOR_LAZY_ADD: return ((uint32_t)lazy->a + lazy->b + lazy->carry) > mask;
+        case SIMULATOR_LAZY_SUB: return lazy->a < ((uint32_t)lazy->b + lazy->carry);
+        default:                 return lazy->carry != 0; /* SIMULATOR_LAZY_INC and SIMULATOR_LAZY_DEC */
+    }
+}
+
+/**
+ * OF of the lazy operation. Adding operands of the same sign or subtracting operands of different signs overflows when
+ * the sign of the result differs from the first operand.
+*/
+static bool simulator_get_lazy_overflow(const simulator_lazy_flags_t* const lazy)
+{
+    const uint16_t sign = (lazy->w == 1) ? 0x8000 : 0x80;
+    const uint16_t same_sign = (uint16_t)~(lazy->a ^ lazy->b);
+    const bool is_add = (lazy->operation == SIMULATOR_LAZY_ADD) || (lazy->operation == SIMULATOR_LAZY_INC);
+    return ((is_add == true) ? same_sign : (uint16_t)~same_sign) & (lazy->a ^ lazy->result) & sign;
+}
+
+/**
+ * Value of the flags register, with the arithmetic flags derived from the lazy operation if there is one.
+*/
+static uint16_t simulator_get_flags(const simulator_t* const sim)
+{
+    const simulator_lazy_flags_t* const lazy = &sim->lazy;
+    if (lazy->operation == SIMULATOR_LAZY_NONE)
+    {
+        return sim->flags;
+    }
+
+    uint16_t flags = (uint16_t)(sim->flags & ~SIMULATOR_FLAGS_ARITHMETIC);
+    if (simulator_get_lazy_carry(lazy) == true)
+    {
+        flags |= SIMULATOR_FLAG_CF;
+    }
+    if ((lazy->a ^ lazy->b ^ lazy->result) & 0x10)
+    {
+        flags |= SIMULATOR_FLAG_AF;
+    }
+    if (simulator_get_lazy_overflow(lazy) == true)
+    {
+        flags |= SIMULATOR_FLAG_OF;
+    }
+    return flags | simulator_get_result_flags(lazy->result, lazy->w);
+}
+
+/**
+ * Bring 'flags' up to date, before an instruction that only changes some of the arithmetic flags.
+*/
+static void simulator_resolve_flags(simulator_t* const sim)
+{
+    sim->flags = simulator_get_flags(sim);
+    sim->lazy.operation = SIMULATOR_LAZY_NONE;
+}
+
+/**
+ * Value of one flag. Conditional jumps mostly test ZF, SF, CF and OF, which take a few operations to derive.
+*/
+static bool simulator_get_flag(const simulator_t* const sim, const uint16_t flag)
+{
+    const simulator_lazy_flags_t* const lazy = &sim->lazy;
+    if ((lazy->operation == SIMULATOR_LAZY_NONE) || ((flag & SIMULATOR_FLAGS_ARITHMETIC) == 0))
+    {
+        return (sim->flags & flag) != 0;
+    }
+
+    switch (flag)
+    {
+        case SIMULATOR_FLAG_ZF: return lazy->result == 0;
+        case SIMULATOR_FLAG_SF: return (lazy->result & ((lazy->w == 1) ? 0x8000 : 0x80)) != 0;
+        case SIMULATOR_FLAG_CF: return simulator_get_lazy_carry(lazy);
+        case SIMULATOR_FLAG_OF: return simulator_get_lazy_overflow(lazy);
+        default:                return (simulator_get_flags(sim) & flag) != 0; /* PF and AF */
+    }
+}
+
+/**
+ * ADD and ADC only record their operands, the flags are derived when they are read.
+*/
+static uint16_t simulator_add(simulator_t* const sim, const uint16_t a, const uint16_t b, const uint16_t carry, const uint8_t w)
+{
+    const uint16_t mask = (w == 1) ? 0xFFFF : 0xFF;
+    const uint16_t result = (uint16_t)((a + b + carry) & mask);
+
+    sim->lazy.operation = SIMULATOR_LAZY_ADD;
+    sim->lazy.w = w;
+    sim->lazy.carry = (uint8_t)carry;
+    sim->lazy.a = a & mask;
+    sim->lazy.b = b & mask;
+    sim->lazy.result = result;
+    return result;
+}
+
+static uint16_t simulator_sub(simulator_t* const sim, const uint16_t a, const uint16_t b, const uint16_t borrow, const uint8_t w)
+{
+    const uint16_t mask = (w == 1) ? 0xFFFF : 0xFF;
+    const uint16_t result = (uint16_t)((a - b - borrow) & mask);
+
+    sim->lazy.operation = SIMULATOR_LAZY_SUB;
+    sim->lazy.w = w;
+    sim->lazy.carry = (uint8_t)borrow;
+    sim->lazy.a = a & mask;
+    sim->lazy.b = b & mask;
+    sim->lazy.result = result;
+    return result;
+}
+
+/**
+ * AND, OR, XOR and TEST clear CF and OF. They set all the arithmetic flags, so they replace any lazy operation.
+*/
+static uint16_t simulator_logic(simulator_t* const sim, const uint16_t result, const uint8_t w)
+{
+    sim->flags = (uint16_t)((sim->flags & ~SIMULATOR_FLAGS_ARITHMETIC) | simulator_get_result_flags(result, w));
+    sim->lazy.operation = SIMULATOR_LAZY_NONE;
+    return result;
+}
+
+/**
+ * Shifts and rotates move one bit at a time, the 8086 doesn't limit the count. Flags only change if the count isn't
+ * zero, and OF is only defined for a count of one.
+*/
+static uint16_t simulator_shift(simulator_t* const sim, const uint8_t operation, uint16_t value, const uint8_t count, const uint8_t w)
+{
+    if (count == 0)
+    {
+        return value;
+    }
+    simulator_resolve_flags(sim);
+
+    const uint16_t mask = (w == 1) ? 0xFFFF : 0xFF;
+    const uint16_t sign = (w == 1) ? 0x8000 : 0x80;
+    const uint16_t original = value & mask;
+    value = original;
+    uint16_t carry = sim->flags & SIMULATOR_FLAG_CF;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        const uint16_t high = (value & sign) ? 1 : 0;
+        const uint16_t low = value & 1;
+        switch (operation)
+        {
+            case OPERATION_SHL: carry = high; value = (uint16_t)(value << 1); break;
+            case OPERATION_SHR: carry = low; value = (uint16_t)(value >> 1); break;
+            case OPERATION_SAR: carry = low; value = (uint16_t)((value >> 1) | (value & sign)); break;
+            case OPERATION_ROL: carry = high; value = (uint16_t)((value << 1) | high); break;
+            case OPERATION_ROR: carry = low; value = (uint16_t)((value >> 1) | (low ? sign : 0)); break;
+            case OPERATION_RCL: value = (uint16_t)((value << 1) | carry); carry = high; break;
+            default: /* OPERATION_RCR */
+            {
+                value = (uint16_t)((value >> 1) | (carry ? sign : 0));
+                carry = low;
+                break;
+            }
+        }
+        value &= mask;
+    }
+
+    /* Rotates leave SF, ZF, PF and AF alone */
+    const bool is_rotate = (operation == OPERATION_ROL) || (operation == OPERATION_ROR) || (operation == OPERATION_RCL) ||
+                           (operation == OPERATION_RCR);
+    sim->flags &= (uint16_t)~((is_rotate == true) ? (SIMULATOR_FLAG_CF | SIMULATOR_FLAG_OF) : SIMULATOR_FLAGS_ARITHMETIC);
+    if (carry)
+    {
+        sim->flags |= SIMULATOR_FLAG_CF;
+    }
+    if (is_rotate == false)
+    {
+        sim->flags |= simulator_get_result_flags(value, w);
+    }
+
+    /* Set when the sign bit changed */
+    if ((original ^ value) & sign)
+    {
+        sim->flags |= SIMULATOR_FLAG_OF;
+    }
+
+    return value;
+}
+
+/**
+ * Stop at an interrupt, there's nothing in the interrupt vector table to run.
+*/
+static void simulator_interrupt(simulator_t* const sim, const uint8_t vector)
+{
+    sim->status = SIMULATOR_STATUS_INTERRUPT;
+    sim->interrupt = vector;
+}
+
+/**
+ * Run a string instruction once, or CX times with a REP prefix. CMPS and SCAS also stop when ZF doesn't match the
+ * prefix.
+*/
+static void simulator_string(simulator_t* const sim, const instruction_t* const inst)
+{
+    const bool is_repeated = (inst->flags & (INSTRUCTION_FLAG_REP | INSTRUCTION_FLAG_REPNE)) != 0;
+    const uint16_t step = (uint16_t)(((sim->flags & SIMULATOR_FLAG_DF) ? -1 : 1) * ((inst->w == 1) ? 2 : 1));
+    const uint16_t source_segment = (inst->flags & INSTRUCTION_FLAG_SEGMENT_OVERRIDE) ? sim->registers[REG(inst->segment)] : DS;
+    if ((is_repeated == true) && (CX == 0))
+    {
+        return;
+    }
+
+    while (true)
+    {
+        const uint32_t source = simulator_get_linear(source_segment, SI);
+        const uint32_t destination = simulator_get_linear(ES, DI);
+        const uint16_t acc = (inst->w == 1) ? AX : (uint8_t)AX;
+        switch (inst->operation)
+        {
+            case OPERATION_MOVS:
+            {
+                if (inst->w == 1)
+                {
+                    simulator_write_word(sim, destination, simulator_read_word(sim, source));
+                }
+                else
+                {
+                    simulator_write_byte(sim, destination, sim->memory[source]);
+                }
+                SI += step;
+                DI += step;
+                break;
+            }
+            case OPERATION_CMPS:
+            {
+                const uint16_t a = (inst->w == 1) ? simulator_read_word(sim, source) : sim->memory[source];
+                const uint16_t b = (inst->w == 1) ? simulator_read_word(sim, destination) : sim->memory[destination];
+                simulator_sub(sim, a, b, 0, inst->w);
+                SI += step;
+                DI += step;
+                break;
+            }
+            case OPERATION_SCAS:
+            {
+                const uint16_t b = (inst->w == 1) ? simulator_read_word(sim, destination) : sim->memory[destination];
+                simulator_sub(sim, acc, b, 0, inst->w);
+                DI += step;
+                break;
+            }
+            case OPERATION_LODS:
+            {
+                if (inst->w == 1)
+                {
+                    AX = simulator_read_word(sim, source);
+                }
+                else
+                {
+                    *simulator_get_byte_register(sim, REGISTER_AL) = sim->memory[source];
+                }
+                SI += step;
+                break;
+            }
+            default: /* OPERATION_STOS */
+            {
+                if (inst->w == 1)
+                {
+                    simulator_write_word(sim, destination, AX);
+                }
+                else
+                {
+                    simulator_write_byte(sim, destination, (uint8_t)AX);
+                }
+                DI += step;
+                break;
+            }
+        }
+
+        if (is_repeated == false)
+        {
+            return;
+        }
+        CX--;
+        if (CX == 0)
+        {
+            return;
+        }
+        if ((inst->operation == OPERATION_CMPS) || (inst->operation == OPERATION_SCAS))
+        {
+            const bool zf = simulator_get_flag(sim, SIMULATOR_FLAG_ZF);
+            if (zf != ((inst->flags & INSTRUCTION_FLAG_REP) != 0))
+            {
+                return;
+            }
+        }
+    }
+}
+
+/**
+ * Find the block at CS:IP, decoding it on the first visit. Returns NULL when the simulation has to stop.
+*/
+static const simulator_block_t* simulator_enter_block(simulator_t* const sim)
+{
+    sim->blocks.is_invalidated = false;
+
+    /* Only code inside the program is cached, so a hit doesn't need the range check */
+    const uint32_t address = simulator_get_linear(CS, sim->ip);
+    const simulator_block_t* block = &sim->blocks.blocks[address & (sim->blocks.capacity - 1)];
+    if ((block->start == address) && (block->count != 0))
+    {
+        return block;
+    }
+
+    if ((address < sim->code_start) || (address >= sim->code_end))
+    {
+        sim->status = SIMULATOR_STATUS_END_OF_PROGRAM;
+        return NULL;
+    }
+
+    block = simulator_blocks_get(&sim->blocks, sim->memory, address, sim->code_end);
+    if (block == NULL)
+    {
+        sim->status = SIMULATOR_STATUS_UNKNOWN_OPCODE;
+    }
+    return block;
+}
+
+void simulator_init(simulator_t* const sim)
+{
+    sim->memory = calloc(SIMULATOR_MEMORY_SIZE, 1);
+    simulator_blocks_init(&sim->blocks, 0, SIMULATOR_MEMORY_SIZE);
+    memset(sim->registers, 0, sizeof(sim->registers));
+    sim->ip = 0;
+    sim->flags = SIMULATOR_FLAGS_FIXED;
+    memset(&sim->lazy, 0, sizeof(sim->lazy));
+    sim->code_start = 0;
+    sim->code_end = 0;
+    sim->inst_count = 0;
+    sim->status = SIMULATOR_STATUS_RUNNING;
+    sim->interrupt = 0;
+}
+
+void simulator_free(simulator_t* const sim)
+{
+    simulator_blocks_free(&sim->blocks);
+    free(sim->memory);
+    sim->memory = NULL;
+}
+
+bool simulator_load(simulator_t* const sim, const uint8_t* const program, const uint32_t program_len, const uint16_t segment, const uint16_t offset)
+{
+    const uint32_t start = simulator_get_linear(segment, offset);
+    if (program_len > (SIMULATOR_MEMORY_SIZE - start))
+    {
+        return false;
+    }
+
+    memcpy(sim->memory + start, program, program_len);
+    simulator_blocks_invalidate(&sim->blocks, 0, SIMULATOR_MEMORY_SIZE);
+    CS = segment;
+    sim->ip = offset;
+    sim->code_start = start;
+    sim->code_end = start + program_len;
+    sim->status = SIMULATOR_STATUS_RUNNING;
+    return true;
+}
+
+/*
+ * Every handler ends by fetching and dispatching the next instruction itself. With computed gotos each handler gets its
+ * own indirect jump, which the branch predictor can tell apart. Compilers without them fall back to a switch.
+*/
+#define SIMULATOR_OPERATIONS(X) \
+    X(OPERATION_NONE, op_unsupported) \
+    X(OPERATION_MOV, op_mov) \
+    X(OPERATION_PUSH, op_push) \
+    X(OPERATION_POP, op_pop) \
+    X(OPERATION_XCHG, op_xchg) \
+    X(OPERATION_IN, op_in) \
+    X(OPERATION_OUT, op_next) \
+    X(OPERATION_XLAT, op_xlat) \
+    X(OPERATION_LEA, op_lea) \
+    X(OPERATION_LDS, op_lds) \
+    X(OPERATION_LES, op_les) \
+    X(OPERATION_LAHF, op_lahf) \
+    X(OPERATION_SAHF, op_sahf) \
+    X(OPERATION_PUSHF, op_pushf) \
+    X(OPERATION_POPF, op_popf) \
+    X(OPERATION_ADD, op_add) \
+    X(OPERATION_ADC, op_adc) \
+    X(OPERATION_INC, op_inc) \
+    X(OPERATION_AAA, op_aaa) \
+    X(OPERATION_DAA, op_daa) \
+    X(OPERATION_SUB, op_sub) \
+    X(OPERATION_SBB, op_sbb) \
+    X(OPERATION_DEC, op_dec) \
+    X(OPERATION_NEG, op_neg) \
+    X(OPERATION_CMP, op_cmp) \
+    X(OPERATION_AAS, op_aas) \
+    X(OPERATION_DAS, op_das) \
+    X(OPERATION_MUL, op_mul) \
+    X(OPERATION_IMUL, op_imul) \
+    X(OPERATION_AAM, op_aam) \
+    X(OPERATION_DIV, op_div) \
+    X(OPERATION_IDIV, op_idiv) \
+    X(OPERATION_AAD, op_aad) \
+    X(OPERATION_CBW, op_cbw) \
+    X(OPERATION_CWD, op_cwd) \
+    X(OPERATION_NOT, op_not) \
+    X(OPERATION_SHL, op_shift) \
+    X(OPERATION_SHR, op_shift) \
+    X(OPERATION_SAR, op_shift) \
+    X(OPERATION_ROL, op_shift) \
+    X(OPERATION_ROR, op_shift) \
+    X(OPERATION_RCL, op_shift) \
+    X(OPERATION_RCR, op_shift) \
+    X(OPERATION_AND, op_and) \
+    X(OPERATION_TEST, op_test) \
+    X(OPERATION_OR, op_or) \
+    X(OPERATION_XOR, op_xor) \
+    X(OPERATION_MOVS, op_string) \
+    X(OPERATION_CMPS, op_string) \
+    X(OPERATION_SCAS, op_string) \
+    X(OPERATION_LODS, op_string) \
+    X(OPERATION_STOS, op_string) \
+    X(OPERATION_CALL, op_call) \
+    X(OPERATION_JMP, op_jmp) \
+    X(OPERATION_RET, op_ret) \
+    X(OPERATION_RETF, op_retf) \
+    X(OPERATION_JE, op_je) \
+    X(OPERATION_JL, op_jl) \
+    X(OPERATION_JLE, op_jle) \
+    X(OPERATION_JB, op_jb) \
+    X(OPERATION_JBE, op_jbe) \
+    X(OPERATION_JP, op_jp) \
+    X(OPERATION_JO, op_jo) \
+    X(OPERATION_JS, op_js) \
+    X(OPERATION_JNE, op_jne) \
+    X(OPERATION_JNL, op_jnl) \
+    X(OPERATION_JG, op_jg) \
+    X(OPERATION_JNB, op_jnb) \
+    X(OPERATION_JA, op_ja) \
+    X(OPERATION_JNP, op_jnp) \
+    X(OPERATION_JNO, op_jno) \
+    X(OPERATION_JNS, op_jns) \
+    X(OPERATION_LOOP, op_loop) \
+    X(OPERATION_LOOPZ, op_loopz) \
+    X(OPERATION_LOOPNZ, op_loopnz) \
+    X(OPERATION_JCXZ, op_jcxz) \
+    X(OPERATION_INT, op_int) \
+    X(OPERATION_INT3, op_int3) \
+    X(OPERATION_INTO, op_into) \
+    X(OPERATION_IRET, op_iret) \
+    X(OPERATION_CLC, op_clc) \
+    X(OPERATION_CMC, op_cmc) \
+    X(OPERATION_STC, op_stc) \
+    X(OPERATION_CLD, op_cld) \
+    X(OPERATION_STD, op_std) \
+    X(OPERATION_CLI, op_cli) \
+    X(OPERATION_STI, op_sti) \
+    X(OPERATION_HLT, op_hlt) \
+    X(OPERATION_WAIT, op_next) \
+    X(OPERATION_ESC, op_next) \
+    X(OPERATION_LOCK, op_unsupported) \
+    X(OPERATION_REP, op_unsupported) \
+    X(OPERATION_SEGMENT, op_unsupported)
+
+#if defined(__GNUC__)
+#define SIMULATOR_HANDLER_ADDRESS(operation, label) [operation] = &&label,
+#define SIMULATOR_DISPATCH() goto *handlers[inst->operation]
+#else
+#define SIMULATOR_HANDLER_CASE(operation, label) case operation: goto label;
+#define SIMULATOR_DISPATCH() switch (inst->operation) { SIMULATOR_OPERATIONS(SIMULATOR_HANDLER_CASE) default: goto op_unsupported; }
+#endif
+
+#define NEXT() \
+    do \
+    { \
+        if ((next == block_end) || (sim->blocks.is_invalidated == true)) \
+        { \
+            const simulator_block_t* const block = simulator_enter_block(sim); \
+            if (block == NULL) \
+            { \
+                return (simulator_status_t)sim->status; \
+            } \
+            next = block->insts; \
+            block_end = next + block->count; \
+        } \
+        if (sim->inst_count == inst_limit) \
+        { \
+            STOP(SIMULATOR_STATUS_LIMIT); \
+        } \
+        inst = next++; \
+        sim->ip += inst->length; \
+        sim->inst_count++; \
+        dst = &inst->operands[0]; \
+        src = &inst->operands[1]; \
+        SIMULATOR_DISPATCH(); \
+    } while (0)
+
+#define JUMP_IF(condition) \
+    do \
+    { \
+        if (condition) \
+        { \
+            sim->ip = (uint16_t)(sim->ip + inst->immediate); \
+        } \
+        NEXT(); \
+    } while (0)
+
+#define STOP(new_status) \
+    do \
+    { \
+        sim->status = (new_status); \
+        return (simulator_status_t)sim->status; \
+    } while (0)
+
+#define FLAG(name) simulator_get_flag(sim, SIMULATOR_FLAG_##name)
+
+static simulator_status_t simulator_execute(simulator_t* const sim, const uint64_t max_inst_count)
+{
+#if defined(__GNUC__)
+    static const void* const handlers[OPERATION_COUNT] = {
+        SIMULATOR_OPERATIONS(SIMULATOR_HANDLER_ADDRESS)
+    };
+#endif
+
+    decoder_init();
+    sim->status = SIMULATOR_STATUS_RUNNING;
+    const uint64_t inst_limit = sim->inst_count + max_inst_count;
+
+    /* Instructions run from the cached block until its end, or until a write changes decoded code */
+    const instruction_t* inst;
+    const instruction_t* next = NULL;
+    const instruction_t* block_end = NULL;
+    const operand_t* dst;
+    const operand_t* src;
+    uint32_t address;
+    uint16_t value;
+    NEXT();
+
+op_unsupported:
+    STOP(SIMULATOR_STATUS_UNKNOWN_OPCODE);
+
+op_next:
+    NEXT();
+
+op_mov:
+    address = simulator_get_address(sim, inst, (dst->kind == OPERAND_MEMORY) ? dst : src);
+    simulator_write(sim, inst, dst, address, simulator_read(sim, inst, src, address));
+    NEXT();
+
+op_push:
+    /* The 8086 pushes the value SP has after the decrement */
+    address = simulator_get_address(sim, inst, dst);
+    value = simulator_read(sim, inst, dst, address);
+    SP -= 2;
+    if ((dst->kind == OPERAND_REGISTER) && (dst->value == REGISTER_SP))
+    {
+        value = SP;
+    }
+    simulator_write_word(sim, simulator_get_linear(SS, SP), value);
+    NEXT();
+
+op_pop:
+    value = simulator_pop(sim);
+    simulator_write(sim, inst, dst, simulator_get_address(sim, inst, dst), value);
+    NEXT();
+
+op_xchg:
+    address = simulator_get_address(sim, inst, (dst->kind == OPERAND_MEMORY) ? dst : src);
+    value = simulator_read(sim, inst, dst, address);
+    simulator_write(sim, inst, dst, address, simulator_read(sim, inst, src, address));
+    simulator_write(sim, inst, src, address, value);
+    NEXT();
+
+op_in:
+    /* No devices are attached, reads float high */
+    simulator_write(sim, inst, dst, 0, 0xFFFF);
+    NEXT();
+
+op_xlat:
+    address = simulator_get_linear(simulator_get_segment(sim, inst, EFFECTIVE_ADDRESS_BX), (uint16_t)(BX + (uint8_t)AX));
+    *simulator_get_byte_register(sim, REGISTER_AL) = sim->memory[address];
+    NEXT();
+
+op_lea:
+    simulator_write(sim, inst, dst, 0, simulator_get_effective_address(sim, src->value, inst->displacement));
+    NEXT();
+
+op_lds:
+    address = simulator_get_address(sim, inst, src);
+    simulator_write(sim, inst, dst, 0, simulator_read_word(sim, address));
+    DS = simulator_read_word(sim, (address + 2) & SIMULATOR_ADDRESS_MASK);
+    NEXT();
+
+op_les:
+    address = simulator_get_address(sim, inst, src);
+    simulator_write(sim, inst, dst, 0, simulator_read_word(sim, address));
+    ES = simulator_read_word(sim, (address + 2) & SIMULATOR_ADDRESS_MASK);
+    NEXT();
+
+op_lahf:
+    *simulator_get_byte_register(sim, REGISTER_AH) = (uint8_t)((simulator_get_flags(sim) & SIMULATOR_FLAGS_LOW) | SIMULATOR_FLAGS_FIXED);
+    NEXT();
+
+op_sahf:
+    simulator_resolve_flags(sim);
+    sim->flags = (uint16_t)((sim->flags & ~SIMULATOR_FLAGS_LOW) | (*simulator_get_byte_register(sim, REGISTER_AH) & SIMULATOR_FLAGS_LOW));
+    NEXT();
+
+op_pushf:
+    simulator_push(sim, simulator_get_flags(sim) | SIMULATOR_FLAGS_PUSHED);
+    NEXT();
+
+op_popf:
+    sim->flags = (uint16_t)((simulator_pop(sim) & SIMULATOR_FLAGS_ALL) | SIMULATOR_FLAGS_FIXED);
+    sim->lazy.operation = SIMULATOR_LAZY_NONE;
+    NEXT();
+
+op_add:
+    address = simulator_get_address(sim, inst, (dst->kind == OPERAND_MEMORY) ? dst : src);
+    value = simulator_add(sim, simulator_read(sim, inst, dst, address), simulator_read(sim, inst, src, address), 0, inst->w);
+    simulator_write(sim, inst, dst, address, value);
+    NEXT();
+
+op_adc:
+    address = simulator_get_address(sim, inst, (dst->kind == OPERAND_MEMORY) ? dst : src);
+    value = simulator_add(sim, simulator_read(sim, inst, dst, address), simulator_read(sim, inst, src, address), FLAG(CF), inst->w);
+    simulator_write(sim, inst, dst, address, value);
+    NEXT();
+
+op_sub:
+    address = simulator_get_address(sim, inst, (dst->kind == OPERAND_MEMORY) ? dst : src);
+    value = simulator_sub(sim, simulator_read(sim, inst, dst, address), simulator_read(sim, inst, src, address), 0, inst->w);
+    simulator_write(sim, inst, dst, address, value);
+    NEXT();
+
+op_sbb:
+    address = simulator_get_address(sim, inst, (dst->kind == OPERAND_MEMORY) ? dst : src);
+    value = simulator_sub(sim, simulator_read(sim, inst, dst, address), simulator_read(sim, inst, src, address), FLAG(CF), inst->w);
+    simulator_write(sim, inst, dst, address, value);
+    NEXT();
+
+op_cmp:
+    address = simulator_get_address(sim, inst, (dst->kind == OPERAND_MEMORY) ? dst : src);
+    simulator_sub(sim, simulator_read(sim, inst, dst, address), simulator_read(sim, inst, src, address), 0, inst->w);
+    NEXT();
+
+op_inc:
+    /* INC and DEC leave CF alone */
+    address = simulator_get_address(sim, inst, dst);
+    {
+        const bool carry = FLAG(CF);
+        value = simulator_add(sim, simulator_read(sim, inst, dst, address), 1, 0, inst->w);
+        sim->lazy.operation = SIMULATOR_LAZY_INC;
+        sim->lazy.carry = carry;
+    }
+    simulator_write(sim, inst, dst, address, value);
+    NEXT();
+
+op_dec:
+    address = simulator_get_address(sim, inst, dst);
+    {
+        const bool carry = FLAG(CF);
+        value = simulator_sub(sim, simulator_read(sim, inst, dst, address), 1, 0, inst->w);
+        sim->lazy.operation = SIMULATOR_LAZY_DEC;
+        sim->lazy.carry = carry;
+    }
+    simulator_write(sim, inst, dst, address, value);
+    NEXT();
+
+op_neg:
+    address = simulator_get_address(sim, inst, dst);
+    value = simulator_sub(sim, 0, simulator_read(sim, inst, dst, address), 0, inst->w);
+    simulator_write(sim, inst, dst, address, value);
+    NEXT();
+
+op_and:
+    address = simulator_get_address(sim, inst, (dst->kind == OPERAND_MEMORY) ? dst : src);
+    value = simulator_logic(sim, simulator_read(sim, inst, dst, address) & simulator_read(sim, inst, src, address), inst->w);
+    simulator_write(sim, inst, dst, address, value);
+    NEXT();
+
+op_test:
+    address = simulator_get_address(sim, inst, (dst->kind == OPERAND_MEMORY) ? dst : src);
+    simulator_logic(sim, simulator_read(sim, inst, dst, address) & simulator_read(sim, inst, src, address), inst->w);
+    NEXT();
+
+op_or:
+    address = simulator_get_address(sim, inst, (dst->kind == OPERAND_MEMORY) ? dst : src);
+    value = simulator_logic(sim, simulator_read(sim, inst, dst, address) | simulator_read(sim, inst, src, address), inst->w);
+    simulator_write(sim, inst, dst, address, value);
+    NEXT();
+
+op_xor:
+    address = simulator_get_address(sim, inst, (dst->kind == OPERAND_MEMORY) ? dst : src);
+    value = simulator_logic(sim, simulator_read(sim, inst, dst, address) ^ simulator_read(sim, inst, src, address), inst->w);
+    simulator_write(sim, inst, dst, address, value);
+    NEXT();
+
+op_not:
+    address = simulator_get_address(sim, inst, dst);
+    simulator_write(sim, inst, dst, address, (uint16_t)~simulator_read(sim, inst, dst, address));
+    NEXT();
+
+op_shift:
+    address = simulator_get_address(sim, inst, dst);
+    value = simulator_shift(sim, inst->operation, simulator_read(sim, inst, dst, address), (uint8_t)simulator_read(sim, inst, src, 0), inst->w);
+    simulator_write(sim, inst, dst, address, value);
+    NEXT();
+
+op_aaa:
+op_aas:
+    /* Adjust AL after adding or subtracting unpacked BCD digits */
+    simulator_resolve_flags(sim);
+    if (((AX & 0xF) > 9) || FLAG(AF))
+    {
+        /* The 8086 adjusts AL and AH separately, a carry out of AL doesn't reach AH like it does on the 80286 */
+        const int32_t sign = (inst->operation == OPERATION_AAA) ? 1 : -1;
+        const uint8_t al = (uint8_t)((uint8_t)AX + (sign * 6));
+        const uint8_t ah = (uint8_t)((AX >> 8) + sign);
+        AX = (uint16_t)((ah << 8) | (al & 0x0F));
+        sim->flags |= SIMULATOR_FLAG_AF | SIMULATOR_FLAG_CF;
+    }
+    else
+    {
+        AX &= 0xFF0F;
+        sim->flags &= (uint16_t)~(SIMULATOR_FLAG_AF | SIMULATOR_FLAG_CF);
+    }
+    NEXT();
+
+op_daa:
+op_das:
+    /* Adjust AL after adding or subtracting packed BCD digits */
+    simulator_resolve_flags(sim);
+    {
+        const uint8_t original = (uint8_t)AX;
+        const bool carry = FLAG(CF);
+        const int32_t sign = (inst->operation == OPERATION_DAA) ? 1 : -1;
+        int32_t al = original;
+        sim->flags &= (uint16_t)~(SIMULATOR_FLAG_PF | SIMULATOR_FLAG_ZF | SIMULATOR_FLAG_SF | SIMULATOR_FLAG_CF);
+        if (((original & 0xF) > 9) || FLAG(AF))
+        {
+            al += sign * 0x06;
+            sim->flags |= SIMULATOR_FLAG_AF;
+            if ((al < 0) || (al > 0xFF) || (carry == true))
+            {
+                sim->flags |= SIMULATOR_FLAG_CF;
+            }
+        }
+        else
+        {
+            sim->flags &= (uint16_t)~SIMULATOR_FLAG_AF;
+        }
+        if ((original > 0x99) || (carry == true))
+        {
+            al += sign * 0x60;
+            sim->flags |= SIMULATOR_FLAG_CF;
+        }
+        *simulator_get_byte_register(sim, REGISTER_AL) = (uint8_t)al;
+        sim->flags |= simulator_get_result_flags((uint8_t)al, 0);
+    }
+    NEXT();
+
+op_mul:
+op_imul:
+    address = simulator_get_address(sim, inst, dst);
+    value = simulator_read(sim, inst, dst, address);
+    simulator_resolve_flags(sim);
+    sim->flags &= (uint16_t)~(SIMULATOR_FLAG_CF | SIMULATOR_FLAG_OF);
+    if (inst->w == 0)
+    {
+        const uint16_t product = (inst->operation == OPERATION_MUL) ? (uint16_t)((uint8_t)AX * (uint8_t)value) :
+                                                                     (uint16_t)((int8_t)AX * (int8_t)value);
+        AX = product;
+        if (product != ((inst->operation == OPERATION_MUL) ? (uint8_t)product : (uint16_t)(int8_t)product))
+        {
+            sim->flags |= SIMULATOR_FLAG_CF | SIMULATOR_FLAG_OF;
+        }
+    }
+    else /* Word */
+    {
+        const uint32_t product = (inst->operation == OPERATION_MUL) ? ((uint32_t)AX * value) :
+                                                                     (uint32_t)((int32_t)(int16_t)AX * (int16_t)value);
+        AX = (uint16_t)product;
+        DX = (uint16_t)(product >> 16);
+        if (product != ((inst->operation == OPERATION_MUL) ? (uint16_t)product : (uint32_t)(int32_t)(int16_t)product))
+        {
+            sim->flags |= SIMULATOR_FLAG_CF | SIMULATOR_FLAG_OF;
+        }
+    }
+    NEXT();
+
+op_div:
+    address = simulator_get_address(sim, inst, dst);
+    value = simulator_read(sim, inst, dst, address);
+    if (inst->w == 0)
+    {
+        if ((value == 0) || ((AX / value) > 0xFF))
+        {
+            simulator_interrupt(sim, SIMULATOR_VECTOR_DIVIDE_ERROR);
+            return (simulator_status_t)sim->status;
+        }
+        AX = (uint16_t)(((AX % value) << 8) | (AX / value));
+    }
+    else /* Word */
+    {
+        const uint32_t dividend = ((uint32_t)DX << 16) | AX;
+        if ((value == 0) || ((dividend / value) > 0xFFFF))
+        {
+            simulator_interrupt(sim, SIMULATOR_VECTOR_DIVIDE_ERROR);
+            return (simulator_status_t)sim->status;
+        }
+        AX = (uint16_t)(dividend / value);
+        DX = (uint16_t)(dividend % value);
+    }
+    NEXT();
+
+op_idiv:
+    address = simulator_get_address(sim, inst, dst);
+    value = simulator_read(sim, inst, dst, address);
+    if (inst->w == 0)
+    {
+        const int32_t dividend = (int16_t)AX;
+        const int32_t divisor = (int8_t)value;
+        if ((divisor == 0) || ((dividend / divisor) > INT8_MAX) || ((dividend / divisor) < (INT8_MIN + 1)))
+        {
+            simulator_interrupt(sim, SIMULATOR_VECTOR_DIVIDE_ERROR);
+            return (simulator_status_t)sim->status;
+        }
+        AX = (uint16_t)(((uint8_t)(dividend % divisor) << 8) | (uint8_t)(dividend / divisor));
+    }
+    else /* Word */
+    {
+        const int64_t dividend = (int32_t)(((uint32_t)DX << 16) | AX);
+        const int64_t divisor = (int16_t)value;
+        if ((divisor == 0) || ((dividend / divisor) > INT16_MAX) || ((dividend / divisor) < (INT16_MIN + 1)))
+        {
+            simulator_interrupt(sim, SIMULATOR_VECTOR_DIVIDE_ERROR);
+            return (simulator_status_t)sim->status;
+        }
+        AX = (uint16_t)(dividend / divisor);
+        DX = (uint16_t)(dividend % divisor);
+    }
+    NEXT();
+
+op_aam:
+    /* The base is the immediate, 10 unless the program encodes another one */
+    value = inst->immediate & 0xFF;
+    if (value == 0)
+    {
+        simulator_interrupt(sim, SIMULATOR_VECTOR_DIVIDE_ERROR);
+        return (simulator_status_t)sim->status;
+    }
+    AX = (uint16_t)((((uint8_t)AX / value) << 8) | ((uint8_t)AX % value));
+    simulator_logic(sim, (uint8_t)AX, 0);
+    NEXT();
+
+op_aad:
+    value = inst->immediate & 0xFF;
+    AX = (uint8_t)((uint8_t)AX + (AX >> 8) * value);
+    simulator_logic(sim, AX, 0);
+    NEXT();
+
+op_cbw:
+    AX = (uint16_t)(int8_t)AX;
+    NEXT();
+
+op_cwd:
+    DX = (AX & 0x8000) ? 0xFFFF : 0;
+    NEXT();
+
+op_string:
+    simulator_string(sim, inst);
+    NEXT();
+
+op_call:
+    if (dst->kind == OPERAND_RELATIVE)
+    {
+        simulator_push(sim, sim->ip);
+        sim->ip = (uint16_t)(sim->ip + inst->immediate);
+    }
+    else if (dst->kind == OPERAND_FAR_POINTER)
+    {
+        simulator_push(sim, CS);
+        simulator_push(sim, sim->ip);
+        CS = inst->immediate;
+        sim->ip = inst->displacement;
+    }
+    else if (inst->flags & INSTRUCTION_FLAG_FAR)
+    {
+        address = simulator_get_address(sim, inst, dst);
+        simulator_push(sim, CS);
+        simulator_push(sim, sim->ip);
+        sim->ip = simulator_read_word(sim, address);
+        CS = simulator_read_word(sim, (address + 2) & SIMULATOR_ADDRESS_MASK);
+    }
+    else /* Near, through a register or memory */
+    {
+        value = simulator_read(sim, inst, dst, simulator_get_address(sim, inst, dst));
+        simulator_push(sim, sim->ip);
+        sim->ip = value;
+    }
+    NEXT();
+
+op_jmp:
+    if (dst->kind == OPERAND_RELATIVE)
+    {
+        sim->ip = (uint16_t)(sim->ip + inst->immediate);
+    }
+    else if (dst->kind == OPERAND_FAR_POINTER)
+    {
+        CS = inst->immediate;
+        sim->ip = inst->displacement;
+    }
+    else if (inst->flags & INSTRUCTION_FLAG_FAR)
+    {
+        address = simulator_get_address(sim, inst, dst);
+        sim->ip = simulator_read_word(sim, address);
+        CS = simulator_read_word(sim, (address + 2) & SIMULATOR_ADDRESS_MASK);
+    }
+    else /* Near, through a register or memory */
+    {
+        sim->ip = simulator_read(sim, inst, dst, simulator_get_address(sim, inst, dst));
+    }
+    NEXT();
+
+op_ret:
+    sim->ip = simulator_pop(sim);
+    SP = (uint16_t)(SP + ((dst->kind == OPERAND_IMMEDIATE) ? inst->immediate : 0));
+    NEXT();
+
+op_retf:
+    sim->ip = simulator_pop(sim);
+    CS = simulator_pop(sim);
+    SP = (uint16_t)(SP + ((dst->kind == OPERAND_IMMEDIATE) ? inst->immediate : 0));
+    NEXT();
+
+op_je:  JUMP_IF(FLAG(ZF));
+op_jne: JUMP_IF(!FLAG(ZF));
+op_jl:  JUMP_IF(FLAG(SF) != FLAG(OF));
+op_jnl: JUMP_IF(FLAG(SF) == FLAG(OF));
+op_jle: JUMP_IF(FLAG(ZF) || (FLAG(SF) != FLAG(OF)));
+op_jg:  JUMP_IF(!FLAG(ZF) && (FLAG(SF) == FLAG(OF)));
+op_jb:  JUMP_IF(FLAG(CF));
+op_jnb: JUMP_IF(!FLAG(CF));
+op_jbe: JUMP_IF(FLAG(CF) || FLAG(ZF));
+op_ja:  JUMP_IF(!FLAG(CF) && !FLAG(ZF));
+op_jp:  JUMP_IF(FLAG(PF));
+op_jnp: JUMP_IF(!FLAG(PF));
+op_jo:  JUMP_IF(FLAG(OF));
+op_jno: JUMP_IF(!FLAG(OF));
+op_js:  JUMP_IF(FLAG(SF));
+op_jns: JUMP_IF(!FLAG(SF));
+
+op_loop:
+    CX--;
+    JUMP_IF(CX != 0);
+
+op_loopz:
+    CX--;
+    JUMP_IF((CX != 0) && FLAG(ZF));
+
+op_loopnz:
+    CX--;
+    JUMP_IF((CX != 0) && !FLAG(ZF));
+
+op_jcxz:
+    JUMP_IF(CX == 0);
+
+op_int:
+    simulator_interrupt(sim, (uint8_t)inst->immediate);
+    return (simulator_status_t)sim->status;
+
+op_int3:
+    simulator_interrupt(sim, SIMULATOR_VECTOR_BREAKPOINT);
+    return (simulator_status_t)sim->status;
+
+op_into:
+    if (FLAG(OF))
+    {
+        simulator_interrupt(sim, SIMULATOR_VECTOR_OVERFLOW);
+        return (simulator_status_t)sim->status;
+    }
+    NEXT();
+
+op_iret:
+    sim->ip = simulator_pop(sim);
+    CS = simulator_pop(sim);
+    sim->flags = (uint16_t)((simulator_pop(sim) & SIMULATOR_FLAGS_ALL) | SIMULATOR_FLAGS_FIXED);
+    sim->lazy.operation = SIMULATOR_LAZY_NONE;
+    NEXT();
+
+op_clc:
+    simulator_resolve_flags(sim);
+    sim->flags &= (uint16_t)~SIMULATOR_FLAG_CF;
+    NEXT();
+
+op_cmc:
+    simulator_resolve_flags(sim);
+    sim->flags ^= SIMULATOR_FLAG_CF;
+    NEXT();
+
+op_stc:
+    simulator_resolve_flags(sim);
+    sim->flags |= SIMULATOR_FLAG_CF;
+    NEXT();
+
+op_cld:
+    sim->flags &= (uint16_t)~SIMULATOR_FLAG_DF;
+    NEXT();
+
+op_std:
+    sim->flags |= SIMULATOR_FLAG_DF;
+    NEXT();
+
+op_cli:
+    sim->flags &= (uint16_t)~SIMULATOR_FLAG_IF;
+    NEXT();
+
+op_sti:
+    sim->flags |= SIMULATOR_FLAG_IF;
+    NEXT();
+
+op_hlt:
+    STOP(SIMULATOR_STATUS_HALTED);
+}
+
+simulator_status_t simulator_run(simulator_t* const sim, const uint64_t max_inst_count)
+{
+    const simulator_status_t status = simulator_execute(sim, max_inst_count);
+
+    /* Callers read the flags register directly */
+    simulator_resolve_flags(sim);
+    return status;
+}
+
+const char* simulator_get_status_name(const uint8_t status)
+{
+    return (status < SIMULATOR_STATUS_COUNT) ? status_names[status] : "?";
+}
+
+void simulator_format_registers(const simulator_t* const sim, output_buffer_t* const buffer)
+{
+    static const char hex_digits[] = "0123456789abcdef";
+    static const struct
+    {
+        uint16_t flag;
+        char name;
+    } flag_names[] = {
+        { SIMULATOR_FLAG_CF, 'C' },
+        { SIMULATOR_FLAG_PF, 'P' },
+        { SIMULATOR_FLAG_AF, 'A' },
+        { SIMULATOR_FLAG_ZF, 'Z' },
+        { SIMULATOR_FLAG_SF, 'S' },
+        { SIMULATOR_FLAG_TF, 'T' },
+        { SIMULATOR_FLAG_IF, 'I' },
+        { SIMULATOR_FLAG_DF, 'D' },
+        { SIMULATOR_FLAG_OF, 'O' },
+    };
+
+    for (uint32_t i = 0; i <= SIMULATOR_REGISTER_COUNT; i++)
+    {
+        const char* const name = (i < SIMULATOR_REGISTER_COUNT) ? register_names[i] : "ip";
+        const uint16_t value = (i < SIMULATOR_REGISTER_COUNT) ? sim->registers[i] : sim->ip;
+        char* cursor = output_buffer_reserve(buffer, 32);
+        memcpy(cursor, "      ", 6);
+        memcpy(cursor + 6, name, 2);
+        memcpy(cursor + 8, ": 0x", 4);
+        cursor += 12;
+        for (int32_t shift = 12; shift >= 0; shift -= 4)
+        {
+            *cursor++ = hex_digits[(value >> shift) & 0xF];
+        }
+        memcpy(cursor, " (", 2);
+        output_buffer_commit(buffer, cursor + 2);
+        output_buffer_append_uint(buffer, value);
+        output_buffer_append_string(buffer, ")\n");
+    }
+
+    const uint16_t flags = simulator_get_flags(sim);
+    output_buffer_append_string(buffer, "   flags: ");
+    for (uint32_t i = 0; i < sizeof(flag_names) / sizeof(flag_names[0]); i++)
+    {
+        if (flags & flag_names[i].flag)
+        {
+            output_buffer_append_char(buffer, flag_names[i].name);
+        }
+    }
+    output_buffer_append_char(buffer, '\n');
+}
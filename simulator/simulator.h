@@ -0,0 +1,150 @@
+/*
+Copyright (c) 2023 Daniel Fedai Larsen
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef SIMULATOR_H
+#define SIMULATOR_H
+
+#include "output_buffer.h"
+#include "simulator_blocks.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* The 8086 addresses 1 MB through 20-bit linear addresses */
+#define SIMULATOR_MEMORY_SIZE (uint32_t)(1U << 20)
+#define SIMULATOR_ADDRESS_MASK (SIMULATOR_MEMORY_SIZE - 1)
+
+/* Word registers in the order of register_id_t from REGISTER_AX on */
+#define SIMULATOR_REGISTER_COUNT 12U
+
+/* Bits of the flags register, see Figure 2-32 in the manual */
+#define SIMULATOR_FLAG_CF (uint16_t)(1U << 0)
+#define SIMULATOR_FLAG_PF (uint16_t)(1U << 2)
+#define SIMULATOR_FLAG_AF (uint16_t)(1U << 4)
+#define SIMULATOR_FLAG_ZF (uint16_t)(1U << 6)
+#define SIMULATOR_FLAG_SF (uint16_t)(1U << 7)
+#define SIMULATOR_FLAG_TF (uint16_t)(1U << 8)
+#define SIMULATOR_FLAG_IF (uint16_t)(1U << 9)
+#define SIMULATOR_FLAG_DF (uint16_t)(1U << 10)
+#define SIMULATOR_FLAG_OF (uint16_t)(1U << 11)
+
+typedef enum
+{
+    SIMULATOR_STATUS_RUNNING = 0,
+    SIMULATOR_STATUS_END_OF_PROGRAM,    /* IP left the loaded program */
+    SIMULATOR_STATUS_HALTED,            /* HLT */
+    SIMULATOR_STATUS_INTERRUPT,         /* Software interrupt or divide error, 'interrupt' has the vector */
+    SIMULATOR_STATUS_UNKNOWN_OPCODE,    /* The bytes at CS:IP don't decode */
+    SIMULATOR_STATUS_LIMIT,             /* The maximum number of instructions was executed */
+    SIMULATOR_STATUS_COUNT
+} simulator_status_t;
+
+typedef enum
+{
+    SIMULATOR_LAZY_NONE = 0,    /* 'flags' is up to date */
+    SIMULATOR_LAZY_ADD,         /* ADD and ADC */
+    SIMULATOR_LAZY_SUB,         /* SUB, SBB, CMP, NEG and the string compares */
+    SIMULATOR_LAZY_INC,
+    SIMULATOR_LAZY_DEC,
+} simulator_lazy_operation_t;
+
+/**
+ * The last operation that set the arithmetic flags, kept instead of the flags themselves. Most flags are overwritten
+ * before anything reads them, so each flag is only derived from the operands and result when it's needed.
+*/
+typedef struct
+{
+    uint8_t operation;  /* simulator_lazy_operation_t */
+    uint8_t w;
+    uint8_t carry;      /* Carry or borrow in for ADD and SUB, CF before the instruction for INC and DEC */
+    uint16_t a;         /* Operands and result, truncated to the width of the operation */
+    uint16_t b;
+    uint16_t result;
+} simulator_lazy_flags_t;
+
+/**
+ * State of a simulated 8086: registers, flags and 1 MB of memory. No BIOS or DOS is loaded, so the simulation stops
+ * at the first interrupt instead of jumping through the interrupt vector table.
+*/
+typedef struct
+{
+    uint16_t registers[SIMULATOR_REGISTER_COUNT];   /* AX CX DX BX SP BP SI DI ES CS SS DS */
+    uint16_t ip;
+    uint16_t flags;                                 /* SIMULATOR_FLAG_*, the arithmetic ones are in 'lazy' during a run */
+    simulator_lazy_flags_t lazy;                    /* Operation the arithmetic flags come from during a run */
+    uint8_t* memory;                                /* SIMULATOR_MEMORY_SIZE bytes */
+    simulator_blocks_t blocks;                      /* Decoded code, dropped when the memory under it changes */
+    uint32_t code_start;                            /* Linear address of the first byte of the loaded program */
+    uint32_t code_end;                              /* Linear address after the last byte of the loaded program */
+    uint64_t inst_count;                            /* Instructions executed so far */
+    uint8_t status;                                 /* simulator_status_t */
+    uint8_t interrupt;                              /* Vector of the interrupt that stopped the simulation */
+} simulator_t;
+
+/**
+ * @brief Allocate zeroed memory and reset all registers
+ *
+ * @param sim Simulator to initialize
+*/
+void simulator_init(simulator_t* const sim);
+
+/**
+ * @brief Free the memory of a simulator
+*/
+void simulator_free(simulator_t* const sim);
+
+/**
+ * @brief Copy a program into memory and point CS:IP at its first byte
+ *
+ * @param sim Simulator to load into
+ * @param program Encoded instructions
+ * @param program_len Length of 'program' in bytes
+ * @param segment Segment to load the program in, CS is set to it
+ * @param offset Offset in the segment, IP is set to it
+ * @return false if the program doesn't fit in memory
+*/
+bool simulator_load(simulator_t* const sim, const uint8_t* const program, const uint32_t program_len, const uint16_t segment, const uint16_t offset);
+
+/**
+ * @brief Execute instructions until the simulation stops
+ *
+ * @param sim Simulator with a loaded program
+ * @param max_inst_count Most instructions to execute in this call
+ * @return Why the simulation stopped
+*/
+simulator_status_t simulator_run(simulator_t* const sim, const uint64_t max_inst_count);
+
+/**
+ * @brief Get a short description of a status
+*/
+const char* simulator_get_status_name(const uint8_t status);
+
+/**
+ * @brief Write the registers, IP and flags, one per line
+ *
+ * @param sim Simulator to describe
+ * @param buffer Buffer to append the description to
+*/
+void simulator_format_registers(const simulator_t* const sim, output_buffer_t* const buffer);
+
+#endif
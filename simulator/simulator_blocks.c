@@ -0,0 +1,211 @@
+/*
+Copyright (c) 2023 Daniel Fedai Larsen
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "simulator_blocks.h"
+
+#include "decoder.h"
+
+#include <stdlib.h>
+
+/**
+ * Instructions that can change CS or IP, or stop the simulation. Code after them may not run next, so they end a
+ * block.
+*/
+static bool simulator_blocks_is_block_end(const instruction_t* const inst)
+{
+    switch (inst->operation)
+    {
+        case OPERATION_CALL:
+        case OPERATION_JMP:
+        case OPERATION_RET:
+        case OPERATION_RETF:
+        case OPERATION_JE:
+        case OPERATION_JL:
+        case OPERATION_JLE:
+        case OPERATION_JB:
+        case OPERATION_JBE:
+        case OPERATION_JP:
+        case OPERATION_JO:
+        case OPERATION_JS:
+        case OPERATION_JNE:
+        case OPERATION_JNL:
+        case OPERATION_JG:
+        case OPERATION_JNB:
+        case OPERATION_JA:
+        case OPERATION_JNP:
+        case OPERATION_JNO:
+        case OPERATION_JNS:
+        case OPERATION_LOOP:
+        case OPERATION_LOOPZ:
+        case OPERATION_LOOPNZ:
+        case OPERATION_JCXZ:
+        case OPERATION_INT:
+        case OPERATION_INT3:
+        case OPERATION_INTO:
+        case OPERATION_IRET:
+        case OPERATION_HLT:
+        {
+            return true;
+        }
+        default:
+        {
+            /* MOV and POP can load CS */
+            return (inst->operands[0].kind == OPERAND_REGISTER) && (inst->operands[0].value == REGISTER_CS);
+        }
+    }
+}
+
+/**
+ * Set or clear the code bits of a range of memory.
+*/
+static void simulator_blocks_mark(simulator_blocks_t* const blocks, const uint32_t start, const uint32_t end, const bool is_code)
+{
+    for (uint32_t address = start; address < end; address++)
+    {
+        const uint8_t bit = (uint8_t)(1U << (address & 7));
+        if (is_code == true)
+        {
+            blocks->code_bits[address >> 3] |= bit;
+        }
+        else
+        {
+            blocks->code_bits[address >> 3] &= (uint8_t)~bit;
+        }
+    }
+}
+
+/**
+ * Clear the code bits of a range that blocks were dropped from. Blocks can overlap, so the ones still cached in the
+ * range mark their bytes again.
+*/
+static void simulator_blocks_unmark(simulator_blocks_t* const blocks, const uint32_t start, const uint32_t end)
+{
+    simulator_blocks_mark(blocks, start, end, false);
+    for (uint32_t i = 0; i < blocks->capacity; i++)
+    {
+        const simulator_block_t* const block = &blocks->blocks[i];
+        if ((block->count != 0) && (block->start < end) && (start < block->end))
+        {
+            simulator_blocks_mark(blocks, block->start, block->end, true);
+        }
+    }
+}
+
+void simulator_blocks_init(simulator_blocks_t* const blocks, const uint32_t capacity, const uint32_t memory_size)
+{
+    uint32_t rounded = 1;
+    while (rounded < ((capacity == 0) ? SIMULATOR_BLOCKS_DEFAULT_CAPACITY : capacity))
+    {
+        rounded <<= 1;
+    }
+
+    blocks->blocks = calloc(rounded, sizeof(simulator_block_t));
+    blocks->insts = calloc((size_t)rounded * SIMULATOR_BLOCK_MAX_INST_COUNT, sizeof(instruction_t));
+    blocks->code_bits = calloc(memory_size >> 3, 1);
+    blocks->capacity = rounded;
+    blocks->memory_size = memory_size;
+    blocks->is_invalidated = false;
+
+    for (uint32_t i = 0; i < rounded; i++)
+    {
+        blocks->blocks[i].insts = &blocks->insts[i * SIMULATOR_BLOCK_MAX_INST_COUNT];
+    }
+}
+
+void simulator_blocks_free(simulator_blocks_t* const blocks)
+{
+    free(blocks->blocks);
+    free(blocks->insts);
+    free(blocks->code_bits);
+    blocks->blocks = NULL;
+    blocks->insts = NULL;
+    blocks->code_bits = NULL;
+    blocks->capacity = 0;
+}
+
+const simulator_block_t* simulator_blocks_get(simulator_blocks_t* const blocks, const uint8_t* const memory, const uint32_t address, const uint32_t end)
+{
+    simulator_block_t* const block = &blocks->blocks[address & (blocks->capacity - 1)];
+    if ((block->count != 0) && (block->start == address))
+    {
+        return block;
+    }
+
+    /* Replace whatever block had the same index */
+    if (block->count != 0)
+    {
+        block->count = 0;
+        simulator_blocks_unmark(blocks, block->start, block->end);
+    }
+
+    uint32_t count = 0;
+    uint32_t next = address;
+    while ((count < SIMULATOR_BLOCK_MAX_INST_COUNT) && (next < end))
+    {
+        instruction_t* const inst = &block->insts[count];
+        if (decoder_decode_one(memory, blocks->memory_size, next, inst) == false)
+        {
+            break;
+        }
+        next += inst->length;
+        count++;
+        if (simulator_blocks_is_block_end(inst) == true)
+        {
+            break;
+        }
+    }
+
+    /* An unknown opcode at the start is reported by the caller, elsewhere it's the start of the next block */
+    if (count == 0)
+    {
+        return NULL;
+    }
+
+    block->start = address;
+    block->end = next;
+    block->count = count;
+    simulator_blocks_mark(blocks, block->start, block->end, true);
+    return block;
+}
+
+void simulator_blocks_invalidate(simulator_blocks_t* const blocks, const uint32_t start, const uint32_t end)
+{
+    uint32_t dropped_start = end;
+    uint32_t dropped_end = start;
+    for (uint32_t i = 0; i < blocks->capacity; i++)
+    {
+        simulator_block_t* const block = &blocks->blocks[i];
+        if ((block->count != 0) && (block->start < end) && (start < block->end))
+        {
+            block->count = 0;
+            dropped_start = (block->start < dropped_start) ? block->start : dropped_start;
+            dropped_end = (block->end > dropped_end) ? block->end : dropped_end;
+        }
+    }
+
+    if (dropped_start < dropped_end)
+    {
+        simulator_blocks_unmark(blocks, dropped_start, dropped_end);
+        blocks->is_invalidated = true;
+    }
+}
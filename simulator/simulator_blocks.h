@@ -0,0 +1,97 @@
+/*
+Copyright (c) 2023 Daniel Fedai Larsen
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef SIMULATOR_BLOCKS_H
+#define SIMULATOR_BLOCKS_H
+
+#include "instruction.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Number of blocks, must be a power of two */
+#define SIMULATOR_BLOCKS_DEFAULT_CAPACITY 1024U
+/* Longest block, longer runs of straight-line code are split */
+#define SIMULATOR_BLOCK_MAX_INST_COUNT 32U
+
+/**
+ * Instructions decoded from a run of memory that ends at the first control transfer. Execution enters at the first
+ * instruction and can only leave after the last one, or by stopping the simulation.
+*/
+typedef struct
+{
+    uint32_t start;          /* Linear address of the first instruction */
+    uint32_t end;            /* Linear address after the last instruction */
+    uint32_t count;          /* Instructions in the block, 0 for an empty entry */
+    instruction_t* insts;    /* SIMULATOR_BLOCK_MAX_INST_COUNT instructions */
+} simulator_block_t;
+
+/**
+ * Direct-mapped cache of decoded blocks indexed by start address. A bit per byte of memory tells if the byte is in a
+ * cached block, so a write only needs a bit test to know it can't have changed cached code, even next to code.
+*/
+typedef struct
+{
+    simulator_block_t* blocks;
+    instruction_t* insts;        /* Instructions of all blocks */
+    uint8_t* code_bits;          /* One bit per byte of memory, set for the bytes of cached blocks */
+    uint32_t capacity;
+    uint32_t memory_size;
+    bool is_invalidated;         /* Set when a block was invalidated, cleared by the caller */
+} simulator_blocks_t;
+
+/**
+ * @brief Allocate an empty cache
+ *
+ * @param blocks Cache to initialize
+ * @param capacity Number of blocks, rounded up to a power of two, 0 for SIMULATOR_BLOCKS_DEFAULT_CAPACITY
+ * @param memory_size Size of the memory code is decoded from
+*/
+void simulator_blocks_init(simulator_blocks_t* const blocks, const uint32_t capacity, const uint32_t memory_size);
+
+/**
+ * @brief Free the blocks of a cache
+*/
+void simulator_blocks_free(simulator_blocks_t* const blocks);
+
+/**
+ * @brief Get the block that starts at an address, decoding it if it isn't cached
+ *
+ * @param blocks Cache to look in and add to
+ * @param memory Memory to decode from
+ * @param address Linear address of the first instruction
+ * @param end Linear address decoding stops at, instructions must start before it
+ * @return The block, or NULL if the instruction at 'address' doesn't decode
+*/
+const simulator_block_t* simulator_blocks_get(simulator_blocks_t* const blocks, const uint8_t* const memory, const uint32_t address, const uint32_t end);
+
+/**
+ * @brief Drop the cached blocks with code in a range of memory, call after the range is written to
+ *
+ * @param blocks Cache to invalidate blocks in
+ * @param start Linear address of the first byte written
+ * @param end Linear address after the last byte written
+*/
+void simulator_blocks_invalidate(simulator_blocks_t* const blocks, const uint32_t start, const uint32_t end);
+
+#endif